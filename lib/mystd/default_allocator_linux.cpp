@@ -40,8 +40,12 @@ byte* default_reallocate(void* passed_address, u64 old_size, u64 size)
     if (address == previous_allocated)
     {
         if (previous_allocated + size > current_break)
-        {
-            default_allocate(size - (current_allocated - previous_allocated));
+        { // grow the break directly, going through default_allocate would move previous_allocated
+            auto amount_to_allocate = align_to(ALLOCATION_BLOCK_SIZE, previous_allocated + size - current_break);
+            auto new_break = current_break + amount_to_allocate;
+            auto resulting_break = (byte*)brk(new_break);
+            assert(resulting_break == new_break, "default_reallocate: failed to allocate memory");
+            current_break = resulting_break;
         }
         current_allocated = previous_allocated + size;
         return previous_allocated;
@@ -15,17 +15,117 @@ Option<String> read_whole_file(CStringView path)
     if (!file_size_result.has_data) { return Option<String>::empty(); }
     auto file_size = file_size_result.value;
 
-    auto result = String::allocate(file_size);
-
     auto file_id = open(path, OpenFlagReadOnly);
-    if (file_id == -1) { return Option<String>::empty(); }
+    if (file_id < 0) { return Option<String>::empty(); }
 
-    auto bytes_read = read(file_id, result.data, file_size);
-    if (bytes_read != file_size) { return Option<String>::empty(); }
+    auto result = String::allocate(max(file_size, (u64)1));
+    while (result.size != file_size)
+    { // reads can be short, e.g. when interrupted by a signal
+        auto read_result = read(file_id, result.data + result.size, file_size - result.size);
+        if (read_result <= 0) { break; }
+        result.size += read_result;
+    }
+    close(file_id);
 
-    result.size = file_size;
+    if (result.size != file_size)
+    {
+        result.deallocate();
+        return Option<String>::empty();
+    }
+    return Option<String>::construct(result);
+}
 
-    close(file_id);
+// maps the file into memory read-only instead of reading it, so the contents get paged in as they're accessed and
+// don't take up memory twice (once in the page cache and once in a buffer); the result has to be released with
+// unmap_whole_file rather than deallocated
+Option<String> map_whole_file(CStringView path)
+{
+    auto file_size_result = get_file_size(path);
+    if (!file_size_result.has_data) { return Option<String>::empty(); }
+    auto file_size = file_size_result.value;
+
+    auto file_id = open(path, OpenFlagReadOnly);
+    if (file_id < 0) { return Option<String>::empty(); }
 
+    String result;
+    result.data = nullptr;
+    result.size = file_size;
+    result.capacity = file_size;
+    if (file_size != 0) // empty mappings aren't allowed
+    {
+        auto mapping = mmap(nullptr, file_size, MemoryProtectionRead, MapFlagPrivate, file_id, 0);
+        if (is_mmap_error(mapping))
+        {
+            close(file_id);
+            return Option<String>::empty();
+        }
+        result.data = (char*)mapping;
+        madvise(mapping, file_size, MemoryAdviceSequential); // only a hint, so failure isn't an error
+    }
+    close(file_id); // the mapping stays valid without the descriptor
     return Option<String>::construct(result);
 }
+
+void unmap_whole_file(String contents)
+{
+    if (contents.size != 0) { munmap(contents.data, contents.size); }
+}
+
+bool write_whole_file(String data, CStringView path)
+{
+    auto file_id = open(path, OpenFalgWriteOnly | OpenFlagCreate | OpenFlagTruncate, 0644);
+    if (file_id < 0) { return false; }
+    u64 bytes_written = 0;
+    while (bytes_written != data.size)
+    { // writes can be short, e.g. when interrupted by a signal
+        auto write_result = write(file_id, data.data + bytes_written, data.size - bytes_written);
+        if (write_result <= 0) { break; }
+        bytes_written += write_result;
+    }
+    auto close_result = close(file_id);
+    return bytes_written == data.size && close_result == 0;
+}
+
+bool delete_file(CStringView path) { return unlink(path) == 0; }
+
+// a file that's read a chunk at a time, for inputs that can't be mapped or read all at once, like pipes and terminals
+struct InputFile
+{
+    Descriptor descriptor;
+    bool is_standard_input;
+
+    static Option<InputFile> open_file(CStringView path)
+    {
+        auto descriptor = open(path, OpenFlagReadOnly);
+        if (descriptor < 0) { return Option<InputFile>::empty(); }
+        InputFile result;
+        result.descriptor = descriptor;
+        result.is_standard_input = false;
+        return Option<InputFile>::construct(result);
+    }
+
+    static InputFile open_standard_input()
+    {
+        InputFile result;
+        result.descriptor = STDIN;
+        result.is_standard_input = true;
+        return result;
+    }
+
+    // returns how many bytes were read, which is 0 only at the end of the file, or -1 on failure; pipes and terminals
+    // give back whatever they have, so there's no point in waiting for the whole buffer to fill up
+    s64 read_into(char* buffer, u64 buffer_size)
+    {
+        while (true)
+        {
+            auto result = read(descriptor, buffer, buffer_size);
+            if (result >= 0) { return result; }
+            if (result != -4) { return -1; } // -4 is EINTR, the read got interrupted by a signal before reading anything
+        }
+    }
+
+    void deallocate()
+    {
+        if (!is_standard_input) { close(descriptor); }
+    }
+};
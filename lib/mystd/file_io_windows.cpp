@@ -13,9 +13,11 @@ static Option<u64> get_file_size(CStringView path)
     {
         return Option<u64>::empty();
     }
-    auto target_file_size = GetFileSize(target_file_handle, NULL);
+    LARGE_INTEGER target_file_size;
+    auto success = GetFileSizeEx(target_file_handle, &target_file_size);
     CloseHandle(target_file_handle);
-    return Option<u64>::construct(target_file_size);
+    if (!success) { return Option<u64>::empty(); }
+    return Option<u64>::construct(target_file_size.QuadPart);
 }
 
 static Option<String> read_whole_file(CStringView path)
@@ -26,21 +28,94 @@ static Option<String> read_whole_file(CStringView path)
         FILE_SHARE_READ,
         NULL,
         OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
         NULL
     );
     if (target_file_handle == INVALID_HANDLE_VALUE)
     {
         return Option<String>::empty();
     }
-    auto target_file_size = GetFileSize(target_file_handle, NULL);
-    auto contents = String::allocate(target_file_size);
-    ReadFile(target_file_handle, contents.data, target_file_size, NULL, NULL);
-    contents.size = target_file_size;
+    LARGE_INTEGER target_file_size;
+    if (!GetFileSizeEx(target_file_handle, &target_file_size))
+    {
+        CloseHandle(target_file_handle);
+        return Option<String>::empty();
+    }
+    auto contents = String::allocate(max((u64)target_file_size.QuadPart, (u64)1));
+    while (contents.size != (u64)target_file_size.QuadPart)
+    { // a single ReadFile can't read more than 4 GiB, and reads can be short
+        auto remaining_size = (u64)target_file_size.QuadPart - contents.size;
+        DWORD bytes_read;
+        auto success = ReadFile(
+            target_file_handle,
+            contents.data + contents.size,
+            (DWORD)min(remaining_size, (u64)0x80000000),
+            &bytes_read,
+            NULL
+        );
+        if (!success || bytes_read == 0) { break; }
+        contents.size += bytes_read;
+    }
     CloseHandle(target_file_handle);
+    if (contents.size != (u64)target_file_size.QuadPart)
+    {
+        contents.deallocate();
+        return Option<String>::empty();
+    }
     return Option<String>::construct(contents);
 }
 
+// maps the file into memory read-only instead of reading it, so the contents get paged in as they're accessed and
+// don't take up memory twice (once in the file cache and once in a buffer); the result has to be released with
+// unmap_whole_file rather than deallocated
+static Option<String> map_whole_file(CStringView path)
+{
+    auto file = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, // the closest there is to a sequential access hint
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) { return Option<String>::empty(); }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        return Option<String>::empty();
+    }
+
+    String result;
+    result.data = nullptr;
+    result.size = file_size.QuadPart;
+    result.capacity = file_size.QuadPart;
+    if (result.size != 0) // empty files can't be mapped
+    {
+        auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            CloseHandle(file);
+            return Option<String>::empty();
+        }
+        result.data = (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping); // the view keeps the mapping alive
+        if (result.data == nullptr)
+        {
+            CloseHandle(file);
+            return Option<String>::empty();
+        }
+    }
+    CloseHandle(file);
+    return Option<String>::construct(result);
+}
+
+static void unmap_whole_file(String contents)
+{
+    if (contents.size != 0) { UnmapViewOfFile(contents.data); }
+}
+
 static bool write_whole_file(String data, CStringView path)
 {
     auto target_file_handle = CreateFileA(
@@ -48,7 +123,7 @@ static bool write_whole_file(String data, CStringView path)
         GENERIC_WRITE,
         FILE_SHARE_READ,
         nullptr,
-        OPEN_ALWAYS,
+        CREATE_ALWAYS, // truncates the file if it already exists
         FILE_ATTRIBUTE_NORMAL,
         nullptr
     );
@@ -115,3 +190,55 @@ static bool file_exists(CStringView path)
     auto dwAttrib = GetFileAttributes(path);
     return dwAttrib != INVALID_FILE_ATTRIBUTES && !(dwAttrib & FILE_ATTRIBUTE_DIRECTORY);
 }
+
+static bool delete_file(CStringView path) { return DeleteFileA(path); }
+
+// a file that's read a chunk at a time, for inputs that can't be mapped or read all at once, like pipes and consoles
+struct InputFile
+{
+    HANDLE handle;
+    bool is_standard_input;
+
+    static Option<InputFile> open_file(CStringView path)
+    {
+        auto handle = CreateFileA(
+            path,
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr
+        );
+        if (handle == INVALID_HANDLE_VALUE) { return Option<InputFile>::empty(); }
+        InputFile result;
+        result.handle = handle;
+        result.is_standard_input = false;
+        return Option<InputFile>::construct(result);
+    }
+
+    static InputFile open_standard_input()
+    {
+        InputFile result;
+        result.handle = GetStdHandle(STD_INPUT_HANDLE);
+        result.is_standard_input = true;
+        return result;
+    }
+
+    // returns how many bytes were read, which is 0 only at the end of the file, or -1 on failure; pipes and consoles
+    // give back whatever they have, so there's no point in waiting for the whole buffer to fill up
+    s64 read_into(char* buffer, u64 buffer_size)
+    {
+        DWORD bytes_read;
+        if (!ReadFile(handle, buffer, (DWORD)min(buffer_size, (u64)0x80000000), &bytes_read, nullptr))
+        { // a pipe whose writing end has been closed is just a file that has ended
+            return GetLastError() == ERROR_BROKEN_PIPE ? 0 : -1;
+        }
+        return bytes_read;
+    }
+
+    void deallocate()
+    {
+        if (!is_standard_input) { CloseHandle(handle); }
+    }
+};
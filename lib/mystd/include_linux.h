@@ -1,4 +1,5 @@
 #include "numbers_linux.cpp"
+#include "simd_linux.cpp"
 #include "numbers_common.cpp"
 #include "syscalls.cpp"
 #include "memory.cpp"
@@ -14,3 +15,6 @@
 #include "macros.cpp"
 #include "file_io_linux.cpp"
 #include "math/vector.cpp"
+#include "time_linux.cpp"
+#include "virtual_memory_linux.cpp"
+#include "threads_linux.cpp"
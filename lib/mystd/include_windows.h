@@ -1,6 +1,7 @@
 #include <Windows.h>
 #include <WinDNS.h>
 #include <TlHelp32.h>
+#include <emmintrin.h>
 #include "numbers_windows.cpp"
 #include "numbers_common.cpp"
 #include "memory.cpp"
@@ -16,6 +17,9 @@
 #include "macros.cpp"
 #include "file_io_windows.cpp"
 #include "math/vector.cpp"
+#include "time_windows.cpp"
+#include "virtual_memory_windows.cpp"
+#include "threads_windows.cpp"
 #include "processes_windows.cpp"
 #include "user_input_windows.cpp"
 #include "environment_windows.cpp"
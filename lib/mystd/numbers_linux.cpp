@@ -27,3 +27,6 @@ T max(T left, T right)
     }
     return right;
 }
+
+// the value can't be 0
+static u32 count_trailing_zeros(u32 value) { return __builtin_ctz(value); }
@@ -8,3 +8,11 @@ typedef unsigned int u32;
 typedef unsigned long u64;
 // byte is defined in c:\program files (x86)\windows kits\10\include\10.0.17763.0\shared\rpcndr.h(191) when using cl
 // typedef char byte;
+
+// the value can't be 0
+static u32 count_trailing_zeros(u32 value)
+{
+    unsigned long result;
+    _BitScanForward(&result, value);
+    return result;
+}
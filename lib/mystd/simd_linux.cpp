@@ -0,0 +1,29 @@
+// the part of SSE2 that's used, declared the way the compiler's own header does it (which can't be included since
+// there are no system headers here), with vector extensions and the compiler's builtins
+
+typedef long long __m128i __attribute__((__vector_size__(16), __may_alias__));
+typedef long long __m128i_u __attribute__((__vector_size__(16), __may_alias__, __aligned__(1)));
+typedef char __v16qi __attribute__((__vector_size__(16)));
+typedef signed char __v16qs __attribute__((__vector_size__(16)));
+
+// the address doesn't have to be aligned
+static inline __m128i _mm_loadu_si128(const __m128i* address) { return *(const __m128i_u*)address; }
+
+static inline __m128i _mm_set1_epi8(char value)
+{
+    return (__m128i)(__v16qi){
+        value, value, value, value, value, value, value, value,
+        value, value, value, value, value, value, value, value
+    };
+}
+
+static inline __m128i _mm_or_si128(__m128i left, __m128i right) { return left | right; }
+static inline __m128i _mm_and_si128(__m128i left, __m128i right) { return left & right; }
+
+// comparisons set all bits of the bytes where they hold and clear them elsewhere, the ordered ones compare signed bytes
+static inline __m128i _mm_cmpeq_epi8(__m128i left, __m128i right) { return (__m128i)((__v16qi)left == (__v16qi)right); }
+static inline __m128i _mm_cmpgt_epi8(__m128i left, __m128i right) { return (__m128i)((__v16qs)left > (__v16qs)right); }
+static inline __m128i _mm_cmplt_epi8(__m128i left, __m128i right) { return (__m128i)((__v16qs)left < (__v16qs)right); }
+
+// bit i is the top bit of the i-th byte
+static inline int _mm_movemask_epi8(__m128i value) { return __builtin_ia32_pmovmskb128((__v16qi)value); }
@@ -186,6 +186,133 @@ static inline s32 mprotect(void* start, u64 length, u64 protection)
     return result;
 }
 
+enum MemoryProtection
+{
+    MemoryProtectionNone = 0,
+    MemoryProtectionRead = 1,
+    MemoryProtectionWrite = 2,
+    MemoryProtectionExecute = 4,
+};
+
+static inline MemoryProtection operator|(MemoryProtection left, MemoryProtection right)
+{
+    return (MemoryProtection)((s32)left | (s32)right);
+}
+
+enum MapFlag
+{
+    MapFlagShared = 0x1,
+    MapFlagPrivate = 0x2,
+    MapFlagFixed = 0x10,
+    MapFlagAnonymous = 0x20,
+    MapFlagNoReserve = 0x4000,
+    MapFlagPopulate = 0x8000,
+    MapFlagHugeTlb = 0x40000,
+};
+
+static inline MapFlag operator|(MapFlag left, MapFlag right)
+{
+    return (MapFlag)((s32)left | (s32)right);
+}
+
+// on failure returns a negated error code, use is_mmap_error to check for it
+static inline void* mmap
+(
+    void* address,
+    u64 length,
+    MemoryProtection protection,
+    MapFlag flags,
+    Descriptor file_descriptor = -1,
+    s64 offset = 0
+)
+{
+    void* result;
+    register s64 flags_register asm("r10") = flags;
+    register s64 file_descriptor_register asm("r8") = file_descriptor;
+    register s64 offset_register asm("r9") = offset;
+    asm volatile
+    (
+        "syscall"
+        : "=a"(result)
+        :
+            "a"(9),
+            "D"(address),
+            "S"(length),
+            "d"(protection),
+            "r"(flags_register),
+            "r"(file_descriptor_register),
+            "r"(offset_register)
+        : "rcx", "r11", "memory"
+    );
+    return result;
+}
+
+static inline bool is_mmap_error(void* mmap_result) { return (u64)mmap_result > (u64)-4096; }
+
+static inline s32 munmap(void* address, u64 length)
+{
+    s32 result;
+    asm volatile
+    (
+        "syscall"
+        : "=a"(result)
+        : "a"(11), "D"(address), "S"(length)
+        : "rcx", "r11", "memory"
+    );
+    return result;
+}
+
+enum MemoryAdvice
+{
+    MemoryAdviceNormal = 0,
+    MemoryAdviceRandom = 1,
+    MemoryAdviceSequential = 2,
+    MemoryAdviceWillNeed = 3,
+    MemoryAdviceDontNeed = 4,
+    MemoryAdviceHugePage = 14,
+    MemoryAdviceCold = 20,
+    MemoryAdvicePageOut = 21,
+};
+
+static inline s32 madvise(void* address, u64 length, MemoryAdvice advice)
+{
+    s32 result;
+    asm volatile
+    (
+        "syscall"
+        : "=a"(result)
+        : "a"(28), "D"(address), "S"(length), "d"(advice)
+        : "rcx", "r11", "memory"
+    );
+    return result;
+}
+
+static inline s32 ftruncate(Descriptor file_descriptor, u64 length)
+{
+    s32 result;
+    asm volatile
+    (
+        "syscall"
+        : "=a"(result)
+        : "a"(77), "D"(file_descriptor), "S"(length)
+        : "rcx", "r11", "memory"
+    );
+    return result;
+}
+
+static inline s32 unlink(const char* path)
+{
+    s32 result;
+    asm volatile
+    (
+        "syscall"
+        : "=a"(result)
+        : "a"(87), "D"(path)
+        : "rcx", "r11", "memory"
+    );
+    return result;
+}
+
 static inline void* brk(void* new_break)
 {
     void* result;
@@ -218,6 +345,31 @@ static inline s32 nanosleep(SleepTime* requested, SleepTime* remaining = nullptr
     return result;
 }
 
+enum Clock
+{
+    ClockRealtime = 0,
+    ClockMonotonic = 1,
+};
+
+struct ClockTime
+{
+    s64 seconds;
+    s64 nanoseconds;
+};
+
+static inline s32 clock_gettime(Clock clock, ClockTime* result_address)
+{
+    s32 result;
+    asm volatile
+    (
+        "syscall"
+        : "=a"(result)
+        : "a"(228), "D"(clock), "S"(result_address)
+        : "rcx", "r11", "memory"
+    );
+    return result;
+}
+
 enum SocketDomain : u16
 {
     SocketDomainUnix = 1,
@@ -0,0 +1,54 @@
+// threads with the same interface on every platform; the default allocator here isn't thread safe, so until it is,
+// spawning a thread runs it to completion right away on the calling one, which keeps code that's written against this
+// interface working, just without running anything in parallel
+
+// lets callers tell users that running things on several threads won't make them any faster here
+static const bool ARE_THREADS_PARALLEL = false;
+
+typedef u8 Thread; // there's nothing to keep track of
+typedef void (*ThreadProcedure)(void* parameter);
+
+// returns nothing if the thread couldn't be created
+static Option<Thread> spawn_thread(ThreadProcedure procedure, void* parameter)
+{
+    procedure(parameter);
+    return Option<Thread>::construct(0);
+}
+
+// waits for the thread to finish
+static void join_thread(Thread) {}
+
+static u32 get_processors_count() { return 1; }
+
+struct Lock
+{
+    static Lock construct() { return {}; }
+
+    void acquire() {}
+
+    void release() {}
+};
+
+// a pointer that every thread has a copy of its own, nullptr on the threads that haven't set it; there's only ever the
+// one thread here
+struct ThreadLocal
+{
+    bool is_allocated;
+    void* value;
+
+    // has to be called before any thread other than the main one uses it
+    void allocate()
+    {
+        if (is_allocated) { return; }
+        value = nullptr;
+        is_allocated = true;
+    }
+
+    void* get() { return is_allocated ? value : nullptr; }
+
+    void set(void* new_value)
+    {
+        assert(is_allocated, "ThreadLocal::set: hasn't been allocated");
+        value = new_value;
+    }
+};
@@ -0,0 +1,90 @@
+// threads with the same interface on every platform, unlike start_thread, which takes a Windows thread procedure
+
+static const bool ARE_THREADS_PARALLEL = true;
+
+typedef HANDLE Thread;
+typedef void (*ThreadProcedure)(void* parameter);
+
+struct ThreadStart
+{
+    ThreadProcedure procedure;
+    void* parameter;
+};
+
+static DWORD WINAPI run_thread_start(LPVOID passed_start)
+{
+    auto start = *(ThreadStart*)passed_start;
+    default_deallocate(passed_start);
+    start.procedure(start.parameter);
+    return 0;
+}
+
+// returns nothing if the thread couldn't be created
+static Option<Thread> spawn_thread(ThreadProcedure procedure, void* parameter)
+{
+    auto start = (ThreadStart*)default_allocate(sizeof(ThreadStart));
+    start->procedure = procedure;
+    start->parameter = parameter;
+    auto thread = CreateThread(nullptr, 0, run_thread_start, start, 0, nullptr);
+    if (thread == nullptr)
+    {
+        default_deallocate(start);
+        return Option<Thread>::empty();
+    }
+    return Option<Thread>::construct(thread);
+}
+
+// waits for the thread to finish
+static void join_thread(Thread thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+static u32 get_processors_count()
+{
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return max(system_info.dwNumberOfProcessors, (DWORD)1);
+}
+
+struct Lock
+{
+    SRWLOCK srw_lock;
+
+    static Lock construct()
+    {
+        Lock result;
+        InitializeSRWLock(&result.srw_lock);
+        return result;
+    }
+
+    void acquire() { AcquireSRWLockExclusive(&srw_lock); }
+
+    void release() { ReleaseSRWLockExclusive(&srw_lock); }
+};
+
+// a pointer that every thread has a copy of its own, nullptr on the threads that haven't set it; `thread_local` can't
+// be used for this, since it relies on the CRT setting up storage for each thread
+struct ThreadLocal
+{
+    bool is_allocated;
+    DWORD index;
+
+    // has to be called before any thread other than the main one uses it
+    void allocate()
+    {
+        if (is_allocated) { return; }
+        index = TlsAlloc();
+        assert_winapi(index != TLS_OUT_OF_INDEXES, "TlsAlloc");
+        is_allocated = true;
+    }
+
+    void* get() { return is_allocated ? TlsGetValue(index) : nullptr; }
+
+    void set(void* value)
+    {
+        assert(is_allocated, "ThreadLocal::set: hasn't been allocated");
+        TlsSetValue(index, value);
+    }
+};
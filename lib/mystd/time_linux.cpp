@@ -0,0 +1,7 @@
+// monotonic time, only meaningful when compared to other results of this function
+static u64 get_time_in_nanoseconds()
+{
+    ClockTime time;
+    clock_gettime(ClockMonotonic, &time);
+    return (u64)time.seconds * 1000000000 + (u64)time.nanoseconds;
+}
@@ -0,0 +1,12 @@
+// monotonic time, only meaningful when compared to other results of this function
+static u64 get_time_in_nanoseconds()
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    // split into seconds and the remainder so that the multiplication doesn't overflow
+    auto seconds = (u64)(counter.QuadPart / frequency.QuadPart);
+    auto remainder = (u64)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000 + remainder * 1000000000 / (u64)frequency.QuadPart;
+}
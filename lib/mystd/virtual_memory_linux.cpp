@@ -0,0 +1,75 @@
+const u64 PAGE_SIZE = 4096;
+const u64 HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// maps fresh zeroed memory straight from the OS; with use_huge_pages it first tries to get explicit huge pages
+// (MAP_HUGETLB, which only works if the system has some reserved) and otherwise asks for transparent huge pages;
+// returns nullptr on failure
+static byte* allocate_pages(u64 size, bool use_huge_pages)
+{
+    auto protection = MemoryProtectionRead | MemoryProtectionWrite;
+    auto flags = MapFlagPrivate | MapFlagAnonymous;
+    if (!use_huge_pages)
+    {
+        auto result = mmap(nullptr, size, protection, flags);
+        return is_mmap_error(result) ? nullptr : (byte*)result;
+    }
+
+    size = align_to(HUGE_PAGE_SIZE, size);
+    auto huge_tlb_result = mmap(nullptr, size, protection, flags | MapFlagHugeTlb);
+    if (!is_mmap_error(huge_tlb_result)) { return (byte*)huge_tlb_result; }
+
+    // transparent huge pages can only back memory aligned to the huge page size, so we map a bit more than needed and
+    // unmap whatever sticks out of the aligned range
+    auto mapping_size = size + HUGE_PAGE_SIZE;
+    auto mapping = mmap(nullptr, mapping_size, protection, flags);
+    if (is_mmap_error(mapping)) { return nullptr; }
+    auto mapping_start = (byte*)mapping;
+    auto result = (byte*)align_to(HUGE_PAGE_SIZE, (u64)mapping_start);
+    if (result != mapping_start) { munmap(mapping_start, result - mapping_start); }
+    auto mapping_end = mapping_start + mapping_size;
+    if (result + size != mapping_end) { munmap(result + size, mapping_end - (result + size)); }
+    madvise(result, size, MemoryAdviceHugePage); // only a hint, so failure isn't an error
+    return result;
+}
+
+static void free_pages(byte* address, u64 size)
+{
+    munmap(address, size);
+}
+
+typedef Descriptor FileHandle;
+
+// creates an empty file for backing memory with, it's unlinked right away so it disappears once the program exits;
+// fails if there already is a file at the path, so that nothing gets overwritten and then unlinked
+static bool create_temporary_file(CStringView path, FileHandle* result)
+{
+    auto file = open(path, OpenFlagReadWrite | OpenFlagCreate | OpenFlagExclusive, 0600);
+    if (file < 0) { return false; }
+    unlink(path);
+    *result = file;
+    return true;
+}
+
+// maps a part of the file into memory, growing the file if needed; the mapping is shared, so the OS can evict its pages
+// by writing them out to the file instead of needing swap, and read them back in when they're accessed again;
+// returns nullptr on failure
+static byte* map_file_pages(FileHandle file, u64 offset, u64 size)
+{
+    if (ftruncate(file, offset + size) != 0) { return nullptr; }
+    auto result = mmap(nullptr, size, MemoryProtectionRead | MemoryProtectionWrite, MapFlagShared, file, offset);
+    return is_mmap_error(result) ? nullptr : (byte*)result;
+}
+
+// tells the OS that the memory isn't going to be used soon; pages of a file mapping get written out and dropped
+static void evict_pages(byte* address, u64 size)
+{
+    madvise(address, size, MemoryAdvicePageOut);
+}
+
+// there's no way to put a hard limit on the resident set on Linux without cgroups
+static const bool CAN_LIMIT_RESIDENT_MEMORY = false;
+
+static bool limit_resident_memory(u64)
+{
+    return false;
+}
@@ -0,0 +1,101 @@
+const u64 PAGE_SIZE = 4096;
+
+static bool lock_memory_privilege_requested = false;
+static bool lock_memory_privilege_enabled = false;
+
+// large pages can only be allocated by processes that have SeLockMemoryPrivilege enabled, the user also has to be
+// granted the "Lock pages in memory" right for this to succeed
+static bool enable_lock_memory_privilege()
+{
+    if (lock_memory_privilege_requested) { return lock_memory_privilege_enabled; }
+    lock_memory_privilege_requested = true;
+
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) { return false; }
+    TOKEN_PRIVILEGES privileges;
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    auto success = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+        && AdjustTokenPrivileges(token, false, &privileges, 0, nullptr, nullptr)
+        && GetLastError() == ERROR_SUCCESS; // AdjustTokenPrivileges "succeeds" even when the privilege isn't granted
+    CloseHandle(token);
+    lock_memory_privilege_enabled = success;
+    return success;
+}
+
+// allocates fresh zeroed memory straight from the OS; with use_huge_pages it tries to get large pages first and falls
+// back to regular ones if they aren't available; returns nullptr on failure
+static byte* allocate_pages(u64 size, bool use_huge_pages)
+{
+    if (use_huge_pages && enable_lock_memory_privilege())
+    {
+        auto large_page_size = GetLargePageMinimum();
+        if (large_page_size != 0)
+        {
+            auto result = (byte*)VirtualAlloc(
+                nullptr,
+                align_to(large_page_size, size),
+                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                PAGE_READWRITE
+            );
+            if (result != nullptr) { return result; }
+        }
+    }
+    return (byte*)VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void free_pages(byte* address, u64 size)
+{
+    VirtualFree(address, 0, MEM_RELEASE);
+}
+
+typedef HANDLE FileHandle;
+
+// creates an empty file for backing memory with, it's deleted once the program exits; fails if there already is a file
+// at the path, so that nothing gets overwritten and then deleted
+static bool create_temporary_file(CStringView path, FileHandle* result)
+{
+    auto file = CreateFileA(
+        path,
+        GENERIC_READ | GENERIC_WRITE,
+        0,
+        nullptr,
+        CREATE_NEW,
+        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+    *result = file;
+    return true;
+}
+
+// maps a part of the file into memory, growing the file if needed; the OS can evict pages of the view by writing them
+// out to the file instead of the page file, and read them back in when they're accessed again; returns nullptr on failure
+static byte* map_file_pages(FileHandle file, u64 offset, u64 size)
+{
+    auto end = offset + size;
+    auto mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)(end >> 32), (DWORD)end, nullptr);
+    if (mapping == nullptr) { return nullptr; }
+    auto result = (byte*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, (DWORD)(offset >> 32), (DWORD)offset, size);
+    CloseHandle(mapping); // the view keeps the mapping alive
+    return result;
+}
+
+// tells the OS that the memory isn't going to be used soon, pages get trimmed from the working set
+static void evict_pages(byte* address, u64 size)
+{
+    VirtualUnlock(address, size); // unlocking memory that isn't locked removes it from the working set
+}
+
+static const bool CAN_LIMIT_RESIDENT_MEMORY = true;
+
+// puts a hard limit on the working set of the process, pages above it get evicted by the OS
+static bool limit_resident_memory(u64 budget)
+{
+    return SetProcessWorkingSetSizeEx(
+        GetCurrentProcess(),
+        16 * PAGE_SIZE,
+        budget,
+        QUOTA_LIMITS_HARDWS_MIN_DISABLE | QUOTA_LIMITS_HARDWS_MAX_ENABLE
+    );
+}
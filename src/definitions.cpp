@@ -0,0 +1,183 @@
+enum NormalFormState
+{
+    NormalFormStateUnknown, // hasn't been demanded yet
+    NormalFormStateComputing, // being computed right now, so the definition is recursive
+    NormalFormStateKnown,
+    NormalFormStateMissing, // the definition is recursive, or computing it failed since it doesn't have one
+};
+
+const u64 NO_FAILED_NORMAL_FORM = (u64)-1;
+
+struct Definition
+{
+    Symbol name;
+    Expression* node;
+    // cached the first time the definition is unfolded, see Reducer::unfold
+    NormalFormState normal_form_state;
+    Expression* normal_form; // normal_form_state = NormalFormStateKnown
+    // the recursion counter that the last attempt at computing the normal form ran out of depth from, or
+    // NO_FAILED_NORMAL_FORM; only attempts from further up are worth making
+    u64 normal_form_failed_at;
+    u64 strict_parameters; // bit i is set if the i-th parameter is strict, see analyze_strictness
+    bool is_recursive; // see mark_recursive_definitions
+    // what the reducer has spent on the definition so far, see Reducer::reduce_head and Profile
+    u64 unfolds_count;
+    u64 allocated_nodes;
+
+    void invalidate_normal_form()
+    {
+        if (normal_form_state == NormalFormStateKnown) { drop(normal_form); }
+        normal_form_state = NormalFormStateUnknown;
+        normal_form_failed_at = NO_FAILED_NORMAL_FORM;
+    }
+};
+
+// definitions of a program indexed by name, built once after parsing so that looking a global up doesn't require
+// scanning through all of the statements
+//
+// every definition also gets a heap node owned by the table, and global variables in the bodies get linked directly to
+// the definition they refer to, so that unfolding a global is a pointer dereference and a reference count increment;
+// recursive definitions end up as cycles in the graph, which is fine since the links don't own anything
+//
+// the nodes are shared with the statements the table was built from (and with whatever got reduced from them), so
+// links can end up outliving the table; they're cleared from the nodes the table can still reach when it's
+// deallocated, and anything that follows a link has to check that it points into its own table first, see owns
+struct DefinitionTable
+{
+    List<Definition> entries; // in the same order as the statements the table was built from
+    SymbolIndex index;
+
+    static DefinitionTable build(List<Statement> statements)
+    {
+        DefinitionTable result;
+        result.entries = List<Definition>::allocate(max(statements.size, (u64)1));
+        result.index = SymbolIndex::allocate(statements.size);
+        for (u64 i = 0; i < statements.size; i++)
+        {
+            Definition definition;
+            definition.name = statements.data[i].name;
+            definition.node = to_node(copy(statements.data[i].expression));
+            definition.normal_form_state = NormalFormStateUnknown;
+            definition.normal_form = nullptr;
+            definition.normal_form_failed_at = NO_FAILED_NORMAL_FORM;
+            definition.strict_parameters = 0;
+            definition.is_recursive = false;
+            definition.unfolds_count = 0;
+            definition.allocated_nodes = 0;
+            result.entries.push(definition);
+            result.index.set(definition.name, i);
+        }
+        result.link_all();
+        return result;
+    }
+
+    void deallocate()
+    {
+        for (u64 i = 0; i < entries.size; i++)
+        {
+            unlink(entries.data[i].node);
+            if (entries.data[i].normal_form_state == NormalFormStateKnown) { unlink(entries.data[i].normal_form); }
+        }
+        for (u64 i = 0; i < entries.size; i++)
+        {
+            entries.data[i].invalidate_normal_form();
+            drop(entries.data[i].node);
+        }
+        entries.deallocate();
+        index.deallocate();
+    }
+
+    // returns nullptr if there's no such definition
+    Definition* get(Symbol name)
+    {
+        auto maybe_entry_index = index.get(name);
+        if (!maybe_entry_index.has_data) { return nullptr; }
+        return &entries.data[maybe_entry_index.value];
+    }
+
+    // checks whether a link points to a definition of this table rather than one of a table that's been deallocated
+    // since, or one that was built over the same statements
+    bool owns(Definition* definition)
+    {
+        return (u64)definition >= (u64)entries.data && (u64)definition < (u64)(entries.data + entries.size);
+    }
+
+    // returns nullptr if there's no such definition
+    Expression* find(Symbol name)
+    {
+        auto definition = get(name);
+        return definition == nullptr ? nullptr : definition->node;
+    }
+
+    // adds a new definition or replaces an existing one, taking ownership of the expression; since any cached normal
+    // form could have been computed using the old definition, all of them are thrown away
+    void define(Symbol name, Expression expression)
+    {
+        auto existing_definition = get(name);
+        if (existing_definition != nullptr)
+        {
+            drop(existing_definition->node);
+            existing_definition->node = to_node(expression);
+        }
+        else
+        {
+            Definition definition;
+            definition.name = name;
+            definition.node = to_node(expression);
+            definition.normal_form_state = NormalFormStateUnknown;
+            definition.normal_form = nullptr;
+            definition.normal_form_failed_at = NO_FAILED_NORMAL_FORM;
+            definition.strict_parameters = 0;
+            definition.is_recursive = false;
+            definition.unfolds_count = 0;
+            definition.allocated_nodes = 0;
+            index.set(name, entries.size);
+            entries.push(definition);
+        }
+        for (u64 i = 0; i < entries.size; i++) { entries.data[i].invalidate_normal_form(); }
+        // variables that didn't refer to anything might do now, and the entries could have moved when growing
+        link_all();
+    }
+
+private:
+    void link_all()
+    {
+        for (u64 i = 0; i < entries.size; i++) { link(entries.data[i].node); }
+    }
+
+    void link(Expression* expression)
+    {
+        switch (expression->type)
+        {
+            case ExpressionTypeVariable:
+                if (!expression->is_bound) { expression->definition = get(expression->global_name); }
+                return;
+            case ExpressionTypeFunction:
+                link(expression->body);
+                return;
+            case ExpressionTypeApplication:
+                link(expression->left);
+                link(expression->right);
+                return;
+        }
+        assert(false);
+    }
+
+    void unlink(Expression* expression)
+    {
+        switch (expression->type)
+        {
+            case ExpressionTypeVariable:
+                if (!expression->is_bound && owns(expression->definition)) { expression->definition = nullptr; }
+                return;
+            case ExpressionTypeFunction:
+                unlink(expression->body);
+                return;
+            case ExpressionTypeApplication:
+                unlink(expression->left);
+                unlink(expression->right);
+                return;
+        }
+        assert(false);
+    }
+};
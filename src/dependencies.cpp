@@ -0,0 +1,233 @@
+// dependency graph of the definitions, used to throw away the definitions that main never uses and to put the rest in
+// an order where each definition comes after the ones it uses; definitions that use each other (directly or not) can't
+// be ordered like that, so they're reported separately as recursive groups
+
+void collect_used_definitions(DefinitionTable definitions, Expression expression, List<u32>* result)
+{
+    switch (expression.type)
+    {
+        case ExpressionTypeVariable:
+            if (!expression.is_bound)
+            {
+                auto maybe_statement_index = definitions.index.get(expression.global_name);
+                if (maybe_statement_index.has_data) { result->push(maybe_statement_index.value); }
+            }
+            return;
+        case ExpressionTypeFunction:
+            collect_used_definitions(definitions, *expression.body, result);
+            return;
+        case ExpressionTypeApplication:
+            collect_used_definitions(definitions, *expression.left, result);
+            collect_used_definitions(definitions, *expression.right, result);
+            return;
+    }
+    assert(false);
+}
+
+const u32 NOT_VISITED = (u32)-1;
+
+struct DependencyGraphFrame
+{
+    u32 definition;
+    u64 next_edge;
+};
+
+// finds strongly connected components of the graph with Tarjan's algorithm, which produces them in an order where every
+// component comes after all of the components it depends on; the traversal uses an explicit stack because generated
+// programs can have dependency chains that are way too long for the call stack
+struct DependencyGraph
+{
+    DefinitionTable definitions;
+    List<u32>* edges; // only computed for visited definitions
+    u32* indices;
+    u32* lowlinks;
+    bool* is_on_stack;
+    u32 next_index;
+    List<u32> stack;
+    List<DependencyGraphFrame> frames;
+
+    List<u32> order;
+    List<List<u32>> recursive_groups;
+
+    static DependencyGraph allocate(DefinitionTable definitions)
+    {
+        DependencyGraph result;
+        result.definitions = definitions;
+        auto count = max(definitions.entries.size, (u64)1);
+        result.edges = (List<u32>*)default_allocate(sizeof(List<u32>) * count);
+        result.indices = (u32*)default_allocate(sizeof(u32) * count);
+        result.lowlinks = (u32*)default_allocate(sizeof(u32) * count);
+        result.is_on_stack = (bool*)default_allocate(sizeof(bool) * count);
+        for (u64 i = 0; i < definitions.entries.size; i++)
+        {
+            result.indices[i] = NOT_VISITED;
+            result.is_on_stack[i] = false;
+        }
+        result.next_index = 0;
+        result.stack = List<u32>::allocate();
+        result.frames = List<DependencyGraphFrame>::allocate();
+        result.order = List<u32>::allocate();
+        result.recursive_groups = List<List<u32>>::allocate();
+        return result;
+    }
+
+    // doesn't deallocate the results
+    void deallocate()
+    {
+        for (u64 i = 0; i < definitions.entries.size; i++)
+        {
+            if (indices[i] != NOT_VISITED) { edges[i].deallocate(); }
+        }
+        default_deallocate(edges);
+        default_deallocate(indices);
+        default_deallocate(lowlinks);
+        default_deallocate(is_on_stack);
+        stack.deallocate();
+        frames.deallocate();
+    }
+
+    void visit(u32 root)
+    {
+        enter(root);
+        while (frames.size != 0)
+        {
+            auto frame = &frames.data[frames.size - 1];
+            auto definition = frame->definition;
+            if (frame->next_edge < edges[definition].size)
+            {
+                auto dependency = edges[definition].data[frame->next_edge];
+                frame->next_edge++;
+                if (indices[dependency] == NOT_VISITED) { enter(dependency); }
+                else if (is_on_stack[dependency])
+                {
+                    lowlinks[definition] = min(lowlinks[definition], indices[dependency]);
+                }
+                continue;
+            }
+
+            frames.pop();
+            if (frames.size != 0)
+            {
+                auto parent = frames.data[frames.size - 1].definition;
+                lowlinks[parent] = min(lowlinks[parent], lowlinks[definition]);
+            }
+            if (lowlinks[definition] == indices[definition]) { pop_component(definition); }
+        }
+    }
+
+private:
+    void enter(u32 definition)
+    {
+        indices[definition] = next_index;
+        lowlinks[definition] = next_index;
+        next_index++;
+        edges[definition] = List<u32>::allocate();
+        collect_used_definitions(definitions, *definitions.entries.data[definition].node, &edges[definition]);
+        stack.push(definition);
+        is_on_stack[definition] = true;
+        DependencyGraphFrame frame;
+        frame.definition = definition;
+        frame.next_edge = 0;
+        frames.push(frame);
+    }
+
+    void pop_component(u32 root)
+    {
+        auto component_start = stack.size;
+        do { component_start--; } while (stack.data[component_start] != root);
+
+        auto component_size = stack.size - component_start;
+        auto is_recursive = component_size > 1 || edges[root].contains(root);
+        auto group = is_recursive ? List<u32>::allocate() : List<u32>{};
+        for (u64 i = component_start; i < stack.size; i++)
+        {
+            is_on_stack[stack.data[i]] = false;
+            order.push(stack.data[i]);
+            if (is_recursive) { group.push(stack.data[i]); }
+        }
+        if (is_recursive) { recursive_groups.push(group); }
+        stack.size = component_start;
+    }
+};
+
+// returns names of the definitions in each recursive group reachable from the root; with remove_dead_definitions set
+// the program is also reordered so that it only has the reachable definitions, with each one placed after the
+// definitions it uses, and the rest are deallocated; if the root isn't defined the program is left as is
+List<List<Symbol>> analyze_dependencies(List<Statement>* program, Symbol root, bool remove_dead_definitions)
+{
+    auto result = List<List<Symbol>>::allocate();
+
+    auto definitions = DefinitionTable::build(*program);
+    auto maybe_root_index = definitions.index.get(root);
+    if (!maybe_root_index.has_data)
+    {
+        definitions.deallocate();
+        return result;
+    }
+
+    auto graph = DependencyGraph::allocate(definitions);
+    graph.visit(maybe_root_index.value);
+
+    for (u64 i = 0; i < graph.recursive_groups.size; i++)
+    {
+        auto group = graph.recursive_groups.data[i];
+        auto names = List<Symbol>::allocate();
+        for (u64 j = 0; j < group.size; j++) { names.push(program->data[group.data[j]].name); }
+        result.push(names);
+        group.deallocate();
+    }
+    graph.recursive_groups.deallocate();
+
+    if (!remove_dead_definitions)
+    {
+        graph.order.deallocate();
+        graph.deallocate();
+        definitions.deallocate();
+        return result;
+    }
+
+    auto kept_statements = List<Statement>::allocate(max(graph.order.size, (u64)1));
+    for (u64 i = 0; i < graph.order.size; i++) { kept_statements.push(program->data[graph.order.data[i]]); }
+    for (u64 i = 0; i < program->size; i++)
+    {
+        if (graph.indices[i] == NOT_VISITED) { program->data[i].deallocate(); }
+    }
+    program->deallocate();
+    *program = kept_statements;
+
+    graph.order.deallocate();
+    graph.deallocate();
+    definitions.deallocate();
+    return result;
+}
+
+// marks the definitions that are part of a recursive group, reachable from main or not; the marks are only valid until
+// the definitions change
+void mark_recursive_definitions(DefinitionTable definitions)
+{
+    auto graph = DependencyGraph::allocate(definitions);
+    for (u32 i = 0; i < definitions.entries.size; i++)
+    {
+        if (graph.indices[i] == NOT_VISITED) { graph.visit(i); }
+        definitions.entries.data[i].is_recursive = false;
+    }
+    for (u64 i = 0; i < graph.recursive_groups.size; i++)
+    {
+        auto group = graph.recursive_groups.data[i];
+        for (u64 j = 0; j < group.size; j++) { definitions.entries.data[group.data[j]].is_recursive = true; }
+        group.deallocate();
+    }
+    graph.recursive_groups.deallocate();
+    graph.order.deallocate();
+    graph.deallocate();
+}
+
+List<List<Symbol>> eliminate_dead_definitions(List<Statement>* program, Symbol root)
+{
+    return analyze_dependencies(program, root, true);
+}
+
+List<List<Symbol>> find_recursive_groups(List<Statement> program, Symbol root)
+{
+    return analyze_dependencies(&program, root, false);
+}
@@ -0,0 +1,153 @@
+struct TermIndexSlot
+{
+    Expression* term; // nullptr for empty slots
+    Symbol name;
+};
+
+// open addressing hash table from terms (keyed by their structural hashes, so alpha-equivalent terms are the same key)
+// to names, used for mapping normal forms of definitions back to the definitions when printing, see fold_definitions
+struct TermIndex
+{
+    TermIndexSlot* slots;
+    u64 slots_count; // always a power of two
+    u64 size;
+
+    static TermIndex allocate(u64 expected_size = 16)
+    {
+        TermIndex result;
+        result.slots_count = 16;
+        while (result.slots_count < expected_size * 2) { result.slots_count *= 2; }
+        result.size = 0;
+        result.slots = allocate_slots(result.slots_count);
+        return result;
+    }
+
+    void deallocate()
+    {
+        for (u64 i = 0; i < slots_count; i++)
+        {
+            if (slots[i].term != nullptr) { drop(slots[i].term); }
+        }
+        default_deallocate(slots);
+    }
+
+    // borrows the term; if the term is already in the index, the name that was added first wins
+    void add(Expression* term, Symbol name)
+    {
+        auto slot_index = find_slot(slots, slots_count, term);
+        if (slots[slot_index].term != nullptr) { return; }
+        slots[slot_index].term = dup(term);
+        slots[slot_index].name = name;
+        size++;
+        if (size * 2 > slots_count) { grow(); }
+    }
+
+    Option<Symbol> find(Expression* expression)
+    {
+        auto slot = slots[find_slot(slots, slots_count, expression)];
+        if (slot.term == nullptr) { return Option<Symbol>::empty(); }
+        return Option<Symbol>::construct(slot.name);
+    }
+
+private:
+    static TermIndexSlot* allocate_slots(u64 count)
+    {
+        auto result = (TermIndexSlot*)default_allocate(sizeof(TermIndexSlot) * count);
+        for (u64 i = 0; i < count; i++) { result[i].term = nullptr; }
+        return result;
+    }
+
+    // terms are only compared when their hashes match, so lookups of terms that aren't in the index are almost always
+    // decided without walking them
+    static u64 find_slot(TermIndexSlot* slots, u64 slots_count, Expression* expression)
+    {
+        auto slot_index = expression->hash & (slots_count - 1);
+        while (slots[slot_index].term != nullptr && !are_equal(slots[slot_index].term, expression))
+        {
+            slot_index = (slot_index + 1) & (slots_count - 1);
+        }
+        return slot_index;
+    }
+
+    void grow()
+    {
+        auto new_slots_count = slots_count * 2;
+        auto new_slots = allocate_slots(new_slots_count);
+        for (u64 i = 0; i < slots_count; i++)
+        {
+            if (slots[i].term == nullptr) { continue; }
+            new_slots[find_slot(new_slots, new_slots_count, slots[i].term)] = slots[i];
+        }
+        default_deallocate(slots);
+        slots = new_slots;
+        slots_count = new_slots_count;
+    }
+};
+
+// indexes normal forms of all of the definitions except for `excluded` (which is meant for main, since its result would
+// otherwise always fold into its own name) and the ones made up by the optimizer; definitions whose normal forms can't
+// be computed are skipped, and so are the ones that normalize to a single variable, since there's nothing to be gained
+// from folding those
+TermIndex index_normal_forms(Reducer reducer, Symbol excluded)
+{
+    auto result = TermIndex::allocate(reducer.definitions.entries.size);
+    for (u64 i = 0; i < reducer.definitions.entries.size; i++)
+    {
+        auto definition = &reducer.definitions.entries.data[i];
+        if (definition->name == excluded || is_generated_symbol(definition->name)) { continue; }
+        drop(reducer.unfold(definition)); // makes sure the normal form has been computed
+        if (definition->normal_form_state != NormalFormStateKnown) { continue; }
+        if (definition->normal_form->type == ExpressionTypeVariable) { continue; }
+        result.add(definition->normal_form, definition->name);
+    }
+    return result;
+}
+
+// returns a new reference to the expression with the largest subterms that are equal to normal forms of definitions
+// replaced by names of those definitions; normal forms of definitions are closed terms, so the subterms that match them
+// are closed as well and can be replaced without worrying about the binders around them
+Expression* fold_definitions(TermIndex index, Expression* expression)
+{
+    auto maybe_name = index.find(expression);
+    if (maybe_name.has_data)
+    {
+        Expression result;
+        result.type = ExpressionTypeVariable;
+        result.depth = expression->depth;
+        result.is_bound = false;
+        result.global_name = maybe_name.value;
+        result.definition = nullptr;
+        return to_node(result);
+    }
+    switch (expression->type)
+    {
+        case ExpressionTypeVariable: return dup(expression);
+        case ExpressionTypeFunction:
+        {
+            auto body = fold_definitions(index, expression->body);
+            if (body == expression->body) { drop(body); return dup(expression); }
+            auto result = copy(*expression);
+            drop(result.body);
+            result.body = body;
+            return to_node(result);
+        }
+        case ExpressionTypeApplication:
+        {
+            auto left = fold_definitions(index, expression->left);
+            auto right = fold_definitions(index, expression->right);
+            if (left == expression->left && right == expression->right)
+            {
+                drop(left);
+                drop(right);
+                return dup(expression);
+            }
+            auto result = copy(*expression);
+            drop(result.left);
+            drop(result.right);
+            result.left = left;
+            result.right = right;
+            return to_node(result);
+        }
+        default: assert(false); return {};
+    }
+}
@@ -1,6 +1,19 @@
 #include "lib/mystd/include_windows.h"
 
+#include "term_heap.cpp"
+#include "symbols.cpp"
 #include "tokenizer.cpp"
 #include "parser.cpp"
+#include "streaming.cpp"
+#include "statements_scan.cpp"
+#include "parallel_parsing.cpp"
+#include "lazy_parsing.cpp"
+#include "definitions.cpp"
+#include "profile.cpp"
+#include "dependencies.cpp"
+#include "types.cpp"
+#include "strictness.cpp"
 #include "reducer.cpp"
+#include "folding.cpp"
+#include "optimizer.cpp"
 #include "interpreter.cpp"
@@ -19,79 +19,68 @@ struct InterpreterResult
     }
 };
 
-Expression resolve_names(List<Statement> definitions, Expression source)
+InterpreterResult interpret(DefinitionTable definitions, Expression main_expression, bool is_guarded = true)
 {
-    switch (source.type)
-    {
-        case ExpressionTypeVariable:
-            if (source.is_bound) { return copy(source); }
-            for (u64 i = 0; i < definitions.size; i++)
-            {
-                auto definition = definitions.data[i];
-                if (definition.name == source.global_name)
-                {
-                    return copy(definition.expression);
-                }
-            }
-            return copy(source);
-        case ExpressionTypeFunction:
-            source.parameter_name = source.parameter_name.copy();
-            source.body = copy_to_heap(resolve_names(definitions, *source.body));
-            return source;
-        case ExpressionTypeApplication:
-            source.left = copy_to_heap(resolve_names(definitions, *source.left));
-            source.right = copy_to_heap(resolve_names(definitions, *source.right));
-            return source;
-        default: assert(false, "Encountered an unknown expression type"); return {};
-    }
+    auto reducer = Reducer::construct(definitions, is_guarded);
+    auto reducing_result = reducer.reduce_in_place(to_node(copy(main_expression)));
+    if (!reducing_result.is_success) { return InterpreterResult::make_fail(reducing_result.error); }
+
+    InterpreterResult result;
+    result.success = true;
+    result.expression = take(reducing_result.value);
+    return result;
 }
 
 InterpreterResult interpret(List<Statement> definitions, Expression main_expression)
 {
-    Expression previous_expression = copy(main_expression);
-    while (true)
-    {
-        auto reducing_result = reduce(previous_expression);
-        if (!reducing_result.is_success)
-        {
-            previous_expression.deallocate();
-            return InterpreterResult::make_fail(reducing_result.error);
-        }
-        auto reduced_expression = reducing_result.value;
-        auto resolved_expression = resolve_names(definitions, reduced_expression);
-        reduced_expression.deallocate();
-        if (resolved_expression == previous_expression)
-        { // we're done
-            previous_expression.deallocate();
-
-            InterpreterResult result;
-            result.success = true;
-            result.expression = resolved_expression;
-            return result;
-        }
-        previous_expression.deallocate();
-        previous_expression = resolved_expression;
-    }
+    auto definition_table = DefinitionTable::build(definitions);
+    auto result = interpret(definition_table, main_expression);
+    definition_table.deallocate();
+    return result;
 }
 
-InterpreterResult interpret(List<Statement> program)
+// when given a folding program, subterms of the result that are equal to normal forms of its definitions (other than
+// main) are printed as names of those definitions, see fold_definitions; it's separate from the program since that one
+// only has the definitions main reaches, and only after they've been optimized; when given a profile, it gets updated
+// with what the run has spent on each of the definitions
+InterpreterResult interpret(
+    List<Statement> program,
+    List<Statement>* folding_program = nullptr,
+    Profile* profile = nullptr
+)
 {
-    Expression main_expression;
-    bool main_expression_found = false;
-    for (u64 i = 0; i < program.size; i++)
-    {
-        auto statement = program.data[i];
-        if (statement.name == "main")
-        {
-            main_expression = statement.expression;
-            main_expression_found = true;
-            break;
-        }
-    }
-    if (!main_expression_found)
+    auto main_name = symbol_table.intern("main");
+    auto definitions = DefinitionTable::build(program);
+    auto main_expression = definitions.find(main_name);
+    if (main_expression == nullptr)
     {
+        definitions.deallocate();
         return InterpreterResult::make_fail(String::copy_from_c_string("Failed to find definition of 'main'"));
     }
 
-    return interpret(program, main_expression);
+    mark_recursive_definitions(definitions);
+    analyze_strictness(definitions);
+
+    // well typed programs always terminate, so they can be reduced without the recursion limit
+    auto type_inference = TypeInference::allocate(definitions);
+    type_inference.infer_definition_types();
+    auto is_well_typed = type_inference.get_definition_type(main_name) != NO_TYPE;
+    type_inference.deallocate();
+
+    auto result = interpret(definitions, *main_expression, !is_well_typed);
+    if (profile != nullptr) { profile->update(definitions); }
+    definitions.deallocate();
+    if (result.success && folding_program != nullptr)
+    {
+        auto folding_definitions = DefinitionTable::build(*folding_program);
+        mark_recursive_definitions(folding_definitions);
+        auto normal_forms = index_normal_forms(Reducer::construct(folding_definitions), main_name);
+        auto unfolded_result = to_node(result.expression);
+        auto folded_result = fold_definitions(normal_forms, unfolded_result);
+        drop(unfolded_result);
+        result.expression = take(folded_result);
+        normal_forms.deallocate();
+        folding_definitions.deallocate();
+    }
+    return result;
 }
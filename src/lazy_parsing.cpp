@@ -0,0 +1,199 @@
+// parses only the definitions that main can reach: after a StatementsScan, a definition gets parsed the first time it's
+// looked up, which is when a definition that's been parsed already refers to it, and the result is kept so nothing
+// gets parsed twice; large libraries mostly consist of definitions a program never uses, and those never get further
+// than the scan
+//
+// statements that don't get parsed don't get checked either, so errors in them go unnoticed, except for duplicates,
+// which the scan finds anyway
+
+const u32 NOT_PARSED = (u32)-1;
+
+struct LazyStatements
+{
+    String source;
+    StatementsScan scan;
+    Lock symbol_table_lock; // there's only the one thread, but ParserChunk takes a lock regardless
+    ParserChunk parser_chunk;
+    List<Statement> parsed_statements; // in the order they got parsed in
+    u32* parsed_positions; // by statement index, NOT_PARSED for the ones that haven't been parsed
+
+    // the source has to fit into MAX_SOURCE_SIZE and has to stay around for as long as this does
+    static LazyStatements* allocate(String source)
+    {
+        auto result = (LazyStatements*)default_allocate(sizeof(LazyStatements));
+        result->source = source;
+        result->scan = StatementsScan::scan(source);
+        result->symbol_table_lock = Lock::construct();
+        result->parser_chunk = ParserChunk::allocate(next_id, &result->symbol_table_lock);
+        result->parsed_statements = List<Statement>::allocate();
+        auto statements_count = result->scan.statements.size;
+        result->parsed_positions = (u32*)default_allocate(sizeof(u32) * max(statements_count, (u64)1));
+        for (u64 i = 0; i < statements_count; i++) { result->parsed_positions[i] = NOT_PARSED; }
+        return result;
+    }
+
+    void deallocate()
+    {
+        for (u64 i = 0; i < parsed_statements.size; i++) { parsed_statements.data[i].deallocate(); }
+        parsed_statements.deallocate();
+        default_deallocate(parsed_positions);
+        parser_chunk.deallocate();
+        scan.deallocate();
+        default_deallocate(this);
+    }
+
+    bool is_parsed(Symbol name)
+    {
+        auto maybe_statement_index = scan.names.get(name);
+        return maybe_statement_index.has_data && parsed_positions[maybe_statement_index.value] != NOT_PARSED;
+    }
+
+    // parses the definition if this is the first time it's looked up; the result is nullptr if there's no such
+    // definition, and is only valid until the next lookup
+    Result<Statement*, String> find(Symbol name)
+    {
+        auto maybe_statement_index = scan.names.get(name);
+        if (!maybe_statement_index.has_data) { return Result<Statement*, String>::success(nullptr); }
+        auto statement_index = maybe_statement_index.value;
+        if (parsed_positions[statement_index] == NOT_PARSED)
+        {
+            auto parsing_result = parse(statement_index);
+            if (!parsing_result.is_success) { return Result<Statement*, String>::fail(parsing_result.error); }
+            parsed_positions[statement_index] = parsed_statements.size;
+            parsed_statements.push(parsing_result.value);
+        }
+        return Result<Statement*, String>::success(&parsed_statements.data[parsed_positions[statement_index]]);
+    }
+
+    // moves the statements that have been parsed so far out, in the order they're in in the source
+    List<Statement> take_statements()
+    {
+        auto result = List<Statement>::allocate(max(parsed_statements.size, (u64)1));
+        for (u64 i = 0; i < scan.statements.size; i++)
+        {
+            if (parsed_positions[i] == NOT_PARSED) { continue; }
+            result.push(parsed_statements.data[parsed_positions[i]]);
+            parsed_positions[i] = NOT_PARSED;
+        }
+        parsed_statements.clear();
+        return result;
+    }
+
+private:
+    // the error is the whole message to report
+    Result<Statement, String> parse(u64 statement_index)
+    {
+        auto range = scan.statements.data[statement_index];
+        auto statement_source = source;
+        statement_source.data += range.offset;
+        statement_source.size = range.size;
+        statement_source.capacity = range.size;
+        auto tokenization_result = tokenize(statement_source);
+        if (!tokenization_result.success)
+        {
+            return Result<Statement, String>::fail(
+                make_tokenization_error(range.offset + tokenization_result.failed_at_index)
+            );
+        }
+        // every parameter takes up at least a character, so IDs from the offset of the statement onwards are its own
+        parser_chunk.next_id = next_id + range.offset;
+        auto parser = ExpressionParser::allocate_for_chunk(
+            statement_source,
+            tokenization_result.tokens,
+            scan.names,
+            statement_index,
+            &parser_chunk
+        );
+        auto statement_result = parser.parse_statement();
+        parser.deallocate();
+        tokenization_result.deallocate();
+        if (!statement_result.is_success)
+        {
+            auto error = String::allocate();
+            error.push("Parsing failed: ");
+            error.push(statement_result.error);
+            statement_result.error.deallocate();
+            return Result<Statement, String>::fail(error);
+        }
+        return statement_result;
+    }
+};
+
+// adds the names of the globals the expression refers to that haven't been parsed yet
+void push_unparsed_global_names(LazyStatements* statements, Expression* expression, List<Symbol>* names)
+{
+    auto pending_expressions = List<Expression*>::allocate();
+    pending_expressions.push(expression);
+    while (pending_expressions.size != 0)
+    {
+        auto current = pending_expressions.data[pending_expressions.size - 1];
+        pending_expressions.pop();
+        switch (current->type)
+        {
+            case ExpressionTypeVariable:
+                if (!current->is_bound && !statements->is_parsed(current->global_name))
+                {
+                    names->push(current->global_name);
+                }
+                break;
+            case ExpressionTypeFunction: pending_expressions.push(current->body); break;
+            case ExpressionTypeApplication:
+                pending_expressions.push(current->right);
+                pending_expressions.push(current->left);
+                break;
+            default: assert(false);
+        }
+    }
+    pending_expressions.deallocate();
+}
+
+// the statements are in the order they're in in the source, but only the ones main can reach are there; the error is
+// the whole message to report, unlike with parse_statements
+ParseStatementsResult parse_reachable_statements(String source, Symbol main_name)
+{
+    if (source.size > MAX_SOURCE_SIZE)
+    {
+        return ParseStatementsResult::make_fail(make_tokenization_error(MAX_SOURCE_SIZE));
+    }
+    assert((u64)next_id + source.size <= (u32)-1, "parse_reachable_statements: ran out of parameter IDs");
+
+    auto statements = LazyStatements::allocate(source);
+    if (statements->scan.has_duplicate)
+    {
+        auto error = statements->scan.make_duplicate_error();
+        statements->deallocate();
+        return ParseStatementsResult::make_fail(error);
+    }
+
+    auto pending_names = List<Symbol>::allocate();
+    pending_names.push(main_name);
+    auto fail = false;
+    String error;
+    while (pending_names.size != 0)
+    {
+        auto name = pending_names.data[pending_names.size - 1];
+        pending_names.pop();
+        if (statements->is_parsed(name)) { continue; } // names can be pending more than once
+        auto find_result = statements->find(name);
+        if (!find_result.is_success)
+        {
+            fail = true;
+            error = find_result.error;
+            break;
+        }
+        // globals that aren't defined are opaque constants
+        if (find_result.value == nullptr) { continue; }
+        push_unparsed_global_names(statements, &find_result.value->expression, &pending_names);
+    }
+    pending_names.deallocate();
+    next_id += source.size;
+
+    if (fail)
+    {
+        statements->deallocate();
+        return ParseStatementsResult::make_fail(error);
+    }
+    auto result = statements->take_statements();
+    statements->deallocate();
+    return ParseStatementsResult::make_success(result);
+}
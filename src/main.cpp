@@ -3,29 +3,263 @@
 struct CliArguments
 {
     CStringView source_file_path;
+    TermHeapSettings term_heap_settings;
+    bool report_recursion;
+    bool fold_result;
+    bool optimize;
+    bool is_pass_disabled[OPTIMIZATION_PASSES_COUNT];
+    bool report_optimizations;
+    bool report_types;
+    bool use_profile;
+    bool stream_source;
+    bool parse_in_parallel;
+    bool parse_lazily;
 };
 
+// checks that the CLI arguments at `source` start with the whole word `word`
+bool starts_with_word(CStringView word, CStringView source)
+{
+    auto word_length = get_c_string_length(word);
+    return c_string_starts_with_case_insensitive(word, source)
+        && (source[word_length] == ' ' || source[word_length] == '\0');
+}
+
 Result<CliArguments, String> parse_cli_arguments(CStringView cli_arguments_string)
 {
     u64 index = 0;
     auto cli_arguments_string_length = get_c_string_length(cli_arguments_string);
 
+    CliArguments result;
+    result.term_heap_settings.use_huge_pages = false;
+    result.term_heap_settings.prefault = false;
+    result.term_heap_settings.spill_file_path = nullptr;
+    result.term_heap_settings.resident_budget = 0;
+    result.report_recursion = false;
+    result.fold_result = false;
+    result.optimize = false;
+    for (u64 i = 0; i < OPTIMIZATION_PASSES_COUNT; i++) { result.is_pass_disabled[i] = false; }
+    result.report_optimizations = false;
+    result.report_types = false;
+    result.use_profile = false;
+    result.stream_source = false;
+    result.parse_in_parallel = false;
+    result.parse_lazily = false;
+
     // skip the first word, which is the program name
+    while (index != cli_arguments_string_length && cli_arguments_string[index] != ' ') { index++; }
+
+    // flags go before the source file path, everything after them is the path
     while (true)
     {
+        while (cli_arguments_string[index] == ' ') { index++; } // skip spaces as there can be multiple
         if (index == cli_arguments_string_length)
         {
             return Result<CliArguments, String>::fail(String::copy_from_c_string("Missing source file path"));
         }
-        if (cli_arguments_string[index] == ' ')
+        auto argument = cli_arguments_string + index;
+        if (argument[0] != '-' || argument[1] != '-') { break; }
+
+        if (starts_with_word("--huge-pages", argument)) { result.term_heap_settings.use_huge_pages = true; }
+        else if (starts_with_word("--prefault", argument)) { result.term_heap_settings.prefault = true; }
+        else if (starts_with_word("--report-recursion", argument)) { result.report_recursion = true; }
+        else if (starts_with_word("--fold", argument)) { result.fold_result = true; }
+        else if (starts_with_word("--optimize", argument)) { result.optimize = true; }
+        else if (starts_with_word("--report-optimizations", argument)) { result.report_optimizations = true; }
+        else if (starts_with_word("--report-types", argument)) { result.report_types = true; }
+        else if (starts_with_word("--profile", argument)) { result.use_profile = true; }
+        else if (starts_with_word("--stream", argument)) { result.stream_source = true; }
+        else if (starts_with_word("--parallel-parsing", argument))
+        { // threads would just run one after the other, which is slower than parsing on one thread
+            if (!ARE_THREADS_PARALLEL)
+            {
+                return Result<CliArguments, String>::fail(
+                    String::copy_from_c_string("Parallel parsing isn't supported on this platform")
+                );
+            }
+            result.parse_in_parallel = true;
+        }
+        else if (starts_with_word("--lazy-parsing", argument)) { result.parse_lazily = true; }
+        else if (
+            starts_with_word("--spill-file", argument)
+                || starts_with_word("--resident-budget", argument)
+                || starts_with_word("--disable-pass", argument)
+        )
+        { // flags with a value, which is the next word
+            auto is_spill_file = starts_with_word("--spill-file", argument);
+            auto is_resident_budget = starts_with_word("--resident-budget", argument);
+            auto flag = is_spill_file ? "--spill-file" : is_resident_budget ? "--resident-budget" : "--disable-pass";
+            while (cli_arguments_string[index] != ' ' && cli_arguments_string[index] != '\0') { index++; }
+            while (cli_arguments_string[index] == ' ') { index++; }
+            auto value = String::allocate();
+            while (cli_arguments_string[index] != ' ' && cli_arguments_string[index] != '\0')
+            {
+                value.push(cli_arguments_string[index]);
+                index++;
+            }
+            if (value.size == 0)
+            {
+                value.deallocate();
+                auto error = String::allocate();
+                error.push("Missing value for flag ");
+                error.push(flag);
+                return Result<CliArguments, String>::fail(error);
+            }
+            if (is_spill_file)
+            {
+                value.make_c_string_compatible();
+                result.term_heap_settings.spill_file_path = value.data;
+            }
+            else if (is_resident_budget)
+            {
+                u64 megabytes = 0;
+                for (u64 i = 0; i < value.size; i++)
+                {
+                    if (value.data[i] < '0' || value.data[i] > '9')
+                    {
+                        auto error = String::allocate();
+                        error.push("Resident budget has to be a number of megabytes, got '");
+                        error.push(value);
+                        error.push('\'');
+                        value.deallocate();
+                        return Result<CliArguments, String>::fail(error);
+                    }
+                    megabytes = megabytes * 10 + (value.data[i] - '0');
+                }
+                value.deallocate();
+                result.term_heap_settings.resident_budget = megabytes * 1024 * 1024;
+            }
+            else
+            {
+                auto maybe_pass = parse_optimization_pass(value);
+                if (!maybe_pass.has_data)
+                {
+                    auto error = String::allocate();
+                    error.push("Unknown optimization pass '");
+                    error.push(value);
+                    error.push('\'');
+                    value.deallocate();
+                    return Result<CliArguments, String>::fail(error);
+                }
+                value.deallocate();
+                result.is_pass_disabled[maybe_pass.value] = true;
+            }
+            continue;
+        }
+        else
+        {
+            auto error = String::allocate();
+            error.push("Unknown flag: '");
+            while (cli_arguments_string[index] != ' ' && cli_arguments_string[index] != '\0')
+            {
+                error.push(cli_arguments_string[index]);
+                index++;
+            }
+            error.push('\'');
+            return Result<CliArguments, String>::fail(error);
+        }
+        while (cli_arguments_string[index] != ' ' && cli_arguments_string[index] != '\0') { index++; }
+    }
+
+    result.source_file_path = cli_arguments_string + index;
+    // a source from the standard input can't be mapped, and there's no file to put its profile next to
+    if (starts_with_word("-", result.source_file_path))
+    {
+        if (result.use_profile)
         {
-            while (cli_arguments_string[index] == ' ') { index++; } // skip spaces as there can be multiple
-            CliArguments result;
-            result.source_file_path = cli_arguments_string + index;
-            return Result<CliArguments, String>::success(result);
+            return Result<CliArguments, String>::fail(
+                String::copy_from_c_string("A source from the standard input can't be profiled")
+            );
         }
-        index++;
+        result.stream_source = true;
+    }
+    // the result can be folded into any definition, and the ones that are never parsed would be missed, which would
+    // make the output depend on how the source was parsed
+    if (result.parse_lazily && result.fold_result)
+    {
+        return Result<CliArguments, String>::fail(
+            String::copy_from_c_string("Folding needs every definition, so it can't be combined with --lazy-parsing")
+        );
+    }
+    // the optimization passes only run when asked for, since bound variables of the result can come out named
+    // differently after them (see optimizer.cpp)
+    auto is_any_pass_disabled = false;
+    for (u64 i = 0; i < OPTIMIZATION_PASSES_COUNT; i++) { is_any_pass_disabled |= result.is_pass_disabled[i]; }
+    if (!result.optimize && (is_any_pass_disabled || result.report_optimizations))
+    {
+        return Result<CliArguments, String>::fail(
+            String::copy_from_c_string("--disable-pass and --report-optimizations only apply with --optimize")
+        );
+    }
+    return Result<CliArguments, String>::success(result);
+}
+
+ParseStatementsResult make_file_not_found_result(CStringView path)
+{
+    auto error = String::allocate();
+    error.push("File '");
+    error.push(path);
+    error.push("' not found");
+    return ParseStatementsResult::make_fail(error);
+}
+
+// the source is mapped rather than read, so it's only paged in as the tokenizer gets to it and never copied; the error
+// of the result is the whole message to report
+ParseStatementsResult map_source(CStringView path, bool parse_lazily, bool parse_in_parallel)
+{
+    auto maybe_source = map_whole_file(path);
+    if (!maybe_source.has_data) { return make_file_not_found_result(path); }
+    auto source = maybe_source.value;
+
+    // only the pages with the definitions main reaches get read in the first place
+    if (parse_lazily)
+    {
+        auto result = parse_reachable_statements(source, symbol_table.intern("main"));
+        unmap_whole_file(source);
+        return result;
+    }
+    if (parse_in_parallel)
+    {
+        auto result = parse_statements_in_parallel(source, get_processors_count());
+        unmap_whole_file(source);
+        return result;
+    }
+
+    auto tokenization_result = tokenize(source);
+    if (!tokenization_result.success)
+    {
+        unmap_whole_file(source);
+        auto error = String::allocate();
+        error.push("Tokenization failed at character ");
+        error.push(tokenization_result.failed_at_index);
+        return ParseStatementsResult::make_fail(error);
+    }
+
+    // tokens point into the mapping, so it has to stay around until parsing is done, the symbol table has its own
+    // copies of the names
+    auto result = parse_statements(source, tokenization_result.tokens);
+    tokenization_result.deallocate();
+    unmap_whole_file(source);
+    if (!result.success)
+    {
+        auto error = String::allocate();
+        error.push("Parsing failed: ");
+        error.push(result.error);
+        result.error.deallocate();
+        result.error = error;
     }
+    return result;
+}
+
+// for sources that can't be mapped, like pipes, or are too large to be in memory all at once, see StatementStream; "-"
+// is the standard input
+ParseStatementsResult stream_source(CStringView path)
+{
+    if (starts_with_word("-", path)) { return parse_statements_from_file(InputFile::open_standard_input()); }
+    auto maybe_file = InputFile::open_file(path);
+    if (!maybe_file.has_data) { return make_file_not_found_result(path); }
+    auto result = parse_statements_from_file(maybe_file.value);
+    maybe_file.value.deallocate();
+    return result;
 }
 
 int main()
@@ -37,37 +271,123 @@ int main()
         return 1;
     }
     auto cli_arguments = cli_arguments_parsing_result.value;
-
-    auto maybe_source = read_whole_file(cli_arguments.source_file_path);
-    if (!maybe_source.has_data)
+    auto term_heap_configuration_result = configure_term_heap(cli_arguments.term_heap_settings);
+    if (!term_heap_configuration_result.is_success)
     {
-        auto error = String::allocate();
-        error.push("File '");
-        error.push(cli_arguments.source_file_path);
-        error.push("' not found\n");
-        print(error);
+        print(term_heap_configuration_result.error, "\n");
         return 1;
     }
-    auto source = maybe_source.value;
 
-    auto tokenization_result = tokenize(source);
-    source.deallocate();
-    if (!tokenization_result.success)
+    auto parsing_result = cli_arguments.stream_source
+        ? stream_source(cli_arguments.source_file_path)
+        : map_source(cli_arguments.source_file_path, cli_arguments.parse_lazily, cli_arguments.parse_in_parallel);
+    if (!parsing_result.success)
     {
-        print("Tokenization failed at character ", tokenization_result.failed_at_index, '\n');
+        print(parsing_result.error, "\n");
         return 1;
     }
 
-    auto parsing_result = parse_statements(tokenization_result.tokens);
-    tokenization_result.deallocate();
-    if (!parsing_result.success)
+    // the result can be folded into the name of any definition, not just the ones main reaches, so folding gets a copy
+    // of all of them from before they're thrown away (or optimized)
+    auto folding_program = List<Statement>::allocate();
+    if (cli_arguments.fold_result)
     {
-        print("Parsing failed: ", parsing_result.error, "\n");
-        return 1;
+        for (u64 i = 0; i < parsing_result.statements.size; i++)
+        {
+            Statement statement;
+            statement.name = parsing_result.statements.data[i].name;
+            statement.expression = copy(parsing_result.statements.data[i].expression);
+            folding_program.push(statement);
+        }
+    }
+    auto recursive_groups = eliminate_dead_definitions(&parsing_result.statements, symbol_table.intern("main"));
+    for (u64 i = 0; i < recursive_groups.size; i++)
+    {
+        auto group = recursive_groups.data[i];
+        if (cli_arguments.report_recursion)
+        {
+            print("Recursive definitions:");
+            for (u64 j = 0; j < group.size; j++) { print(" ", symbol_table.get_name(group.data[j])); }
+            print("\n");
+        }
+        group.deallocate();
+    }
+    recursive_groups.deallocate();
+
+    if (cli_arguments.report_types)
+    {
+        auto definitions = DefinitionTable::build(parsing_result.statements);
+        auto type_inference = TypeInference::allocate(definitions);
+        type_inference.infer_definition_types();
+        for (u64 i = 0; i < definitions.entries.size; i++)
+        {
+            print(symbol_table.get_name(definitions.entries.data[i].name), " : ");
+            auto type = type_inference.definition_types[i];
+            if (type == NO_TYPE) { print("no type\n"); }
+            else
+            {
+                auto type_string = type_inference.to_string(type);
+                print(type_string, "\n");
+                type_string.deallocate();
+            }
+        }
+        type_inference.deallocate();
+        definitions.deallocate();
+    }
+
+    // with --profile, the profile of the previous run goes next to the source file, one that can't be read is the same
+    // as none at all
+    auto profile_path = String::allocate();
+    profile_path.push(cli_arguments.source_file_path);
+    profile_path.push(".profile");
+    profile_path.make_c_string_compatible();
+    auto profile = Profile::allocate();
+    auto maybe_profile_source = cli_arguments.use_profile
+        ? read_whole_file(profile_path.data)
+        : Option<String>::empty();
+    if (maybe_profile_source.has_data)
+    {
+        auto maybe_profile = Profile::parse(maybe_profile_source.value);
+        if (maybe_profile.has_data)
+        {
+            profile.deallocate();
+            profile = maybe_profile.value;
+        }
+        maybe_profile_source.value.deallocate();
+    }
+
+    auto optimization_settings = OptimizationSettings::construct(symbol_table.intern("main"));
+    optimization_settings.profile = cli_arguments.use_profile ? &profile : nullptr;
+    for (u64 i = 0; i < OPTIMIZATION_PASSES_COUNT; i++)
+    {
+        optimization_settings.is_pass_enabled[i] = cli_arguments.optimize && !cli_arguments.is_pass_disabled[i];
+    }
+    auto optimization_reports = optimize(&parsing_result.statements, optimization_settings);
+    if (cli_arguments.report_optimizations)
+    {
+        for (u64 i = 0; i < optimization_reports.size; i++)
+        {
+            auto report = optimization_reports.data[i];
+            print(
+                OPTIMIZATION_PASS_NAMES[report.pass],
+                ": ",
+                report.size_before,
+                " -> ",
+                report.size_after,
+                " nodes\n"
+            );
+        }
     }
+    optimization_reports.deallocate();
 
-    auto interpretation_result = interpret(parsing_result.statements);
+    auto interpretation_result = interpret(
+        parsing_result.statements,
+        cli_arguments.fold_result ? &folding_program : nullptr,
+        cli_arguments.use_profile ? &profile : nullptr
+    );
     parsing_result.deallocate();
+    for (u64 i = 0; i < folding_program.size; i++) { folding_program.data[i].deallocate(); }
+    folding_program.deallocate();
     if (!interpretation_result.success)
     {
         print("Interpretation failed: ", interpretation_result.error, "\n");
@@ -76,5 +396,17 @@ int main()
     print(interpretation_result.expression);
     interpretation_result.deallocate();
 
+    if (cli_arguments.use_profile)
+    {
+        auto profile_source = profile.serialize();
+        if (!write_whole_file(profile_source, profile_path.data))
+        {
+            print("\nFailed to write profile '", profile_path, "'");
+        }
+        profile_source.deallocate();
+    }
+    profile.deallocate();
+    profile_path.deallocate();
+
     return 0;
 }
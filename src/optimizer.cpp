@@ -0,0 +1,601 @@
+// passes that rewrite the definitions of a program after it's been parsed, so that the reducer starts from terms that
+// are smaller and have less work left in them; main still reduces to the same term up to alpha equivalence, but its
+// bound variables can end up named after different binders (e.g. `\ y . y` instead of `\ x . x`) once definitions
+// get inlined or reduced ahead of time, so the CLI only runs the passes with --optimize
+
+enum OptimizationPass
+{
+    OptimizationPassInlining,
+    OptimizationPassSpecialization,
+    OptimizationPassPreReduction,
+    OptimizationPassEtaContraction,
+    OptimizationPassUnusedParameterElimination,
+    OPTIMIZATION_PASSES_COUNT,
+};
+
+const char* OPTIMIZATION_PASS_NAMES[OPTIMIZATION_PASSES_COUNT] = {
+    "inlining",
+    "specialization",
+    "pre-reduction",
+    "eta-contraction",
+    "unused-parameter-elimination",
+};
+
+Option<OptimizationPass> parse_optimization_pass(String name)
+{
+    for (u64 i = 0; i < OPTIMIZATION_PASSES_COUNT; i++)
+    {
+        if (name == OPTIMIZATION_PASS_NAMES[i]) { return Option<OptimizationPass>::construct((OptimizationPass)i); }
+    }
+    return Option<OptimizationPass>::empty();
+}
+
+struct OptimizationSettings
+{
+    bool is_pass_enabled[OPTIMIZATION_PASSES_COUNT];
+    Symbol root; // the definition whose meaning has to stay exactly the same, i.e. main
+    Profile* profile; // from a previous run of the program, nullptr if there isn't one
+
+    static OptimizationSettings construct(Symbol root)
+    {
+        OptimizationSettings result;
+        for (u64 i = 0; i < OPTIMIZATION_PASSES_COUNT; i++) { result.is_pass_enabled[i] = true; }
+        result.root = root;
+        result.profile = nullptr;
+        return result;
+    }
+};
+
+struct OptimizationPassReport
+{
+    OptimizationPass pass;
+    u64 size_before; // in nodes, summed over all of the definitions
+    u64 size_after;
+};
+
+// number of nodes in the expression, counting shared nodes as many times as they're referenced
+u64 get_size(Expression expression)
+{
+    switch (expression.type)
+    {
+        case ExpressionTypeVariable: return 1;
+        case ExpressionTypeFunction: return 1 + get_size(*expression.body);
+        case ExpressionTypeApplication: return 1 + get_size(*expression.left) + get_size(*expression.right);
+        default: assert(false); return {};
+    }
+}
+
+u64 get_size(List<Statement> program)
+{
+    u64 result = 0;
+    for (u64 i = 0; i < program.size; i++) { result += get_size(program.data[i].expression); }
+    return result;
+}
+
+bool has_global_variables(Expression expression)
+{
+    switch (expression.type)
+    {
+        case ExpressionTypeVariable: return !expression.is_bound;
+        case ExpressionTypeFunction: return has_global_variables(*expression.body);
+        case ExpressionTypeApplication:
+            return has_global_variables(*expression.left) || has_global_variables(*expression.right);
+        default: assert(false); return {};
+    }
+}
+
+// inlining
+
+const u64 INLINING_SIZE_LIMIT = 16;
+const u64 HOT_INLINING_SIZE_LIMIT = 64; // for definitions that the profile says are unfolded a lot
+
+// takes ownership of the expression, global variables that refer to definitions marked as inlinable are replaced with
+// their bodies; definitions are closed terms, so their bodies can be put under any binders as they are
+Expression* inline_definitions(DefinitionTable definitions, bool* is_inlinable, Expression* expression)
+{
+    switch (expression->type)
+    {
+        case ExpressionTypeVariable:
+        {
+            if (expression->is_bound) { return expression; }
+            auto maybe_definition_index = definitions.index.get(expression->global_name);
+            if (!maybe_definition_index.has_data || !is_inlinable[maybe_definition_index.value]) { return expression; }
+            drop(expression);
+            return dup(definitions.entries.data[maybe_definition_index.value].node);
+        }
+        case ExpressionTypeFunction:
+            expression = make_unique(expression);
+            expression->body = inline_definitions(definitions, is_inlinable, expression->body);
+            expression->parameter_usage = ParameterUsageUnknown;
+            return rehash(expression);
+        case ExpressionTypeApplication:
+            expression = make_unique(expression);
+            expression->left = inline_definitions(definitions, is_inlinable, expression->left);
+            expression->right = inline_definitions(definitions, is_inlinable, expression->right);
+            return rehash(expression);
+        default: assert(false); return {};
+    }
+}
+
+// small definitions that aren't recursive get inlined into all of their usages; definitions are handled in dependency
+// order, so a definition's body already has everything inlined into it by the time it's inlined somewhere else
+void run_inlining_pass(List<Statement> program, Profile* profile)
+{
+    auto definitions = DefinitionTable::build(program);
+    auto graph = DependencyGraph::allocate(definitions);
+    for (u32 i = 0; i < program.size; i++)
+    {
+        if (graph.indices[i] == NOT_VISITED) { graph.visit(i); }
+    }
+
+    auto is_inlinable = (bool*)default_allocate(sizeof(bool) * max(program.size, (u64)1));
+    for (u64 i = 0; i < program.size; i++) { is_inlinable[i] = true; }
+    for (u64 i = 0; i < graph.recursive_groups.size; i++)
+    {
+        auto group = graph.recursive_groups.data[i];
+        for (u64 j = 0; j < group.size; j++) { is_inlinable[group.data[j]] = false; }
+        group.deallocate();
+    }
+    graph.recursive_groups.deallocate();
+
+    for (u64 i = 0; i < graph.order.size; i++)
+    {
+        auto definition_index = graph.order.data[i];
+        auto statement = &program.data[definition_index];
+        statement->expression = take(inline_definitions(definitions, is_inlinable, to_node(statement->expression)));
+        auto size_limit = profile != nullptr && profile->is_hot(statement->name)
+            ? HOT_INLINING_SIZE_LIMIT
+            : INLINING_SIZE_LIMIT;
+        is_inlinable[definition_index] = is_inlinable[definition_index]
+            && get_size(statement->expression) <= size_limit;
+
+        // later definitions have to see the new body
+        auto entry = &definitions.entries.data[definition_index];
+        drop(entry->node);
+        entry->node = to_node(copy(statement->expression));
+    }
+
+    default_deallocate(is_inlinable);
+    graph.order.deallocate();
+    graph.deallocate();
+    definitions.deallocate();
+}
+
+// specialization
+
+const u64 SPECIALIZATION_SIZE_LIMIT = 256;
+// steps the reductions of the whole pass can take together, see Reducer::steps_left
+const u64 SPECIALIZATION_STEPS_BUDGET = 1 << 16;
+
+// checks that the expression doesn't use any variables bound outside of it
+bool is_closed(Expression expression, u32 depth = 0)
+{
+    switch (expression.type)
+    {
+        case ExpressionTypeVariable: return !expression.is_bound || expression.bound_index < depth;
+        case ExpressionTypeFunction: return is_closed(*expression.body, depth + 1);
+        case ExpressionTypeApplication:
+            return is_closed(*expression.left, depth) && is_closed(*expression.right, depth);
+        default: assert(false); return {};
+    }
+}
+
+// applications of a definition to arguments that are known statically (closed terms, which can still contain globals)
+// are reduced ahead of time into new definitions, and the applications are replaced with references to those; the
+// reduction goes under binders, so a partial application like `add two` turns into a function that has the work that
+// only depends on `two` already done; every distinct configuration (the definition with its arguments, compared up to
+// alpha equivalence) is only specialized once, and the rest of its occurrences refer to the same definition;
+// configurations are reduced eagerly, whether or not the program would ever have reduced them, so the reductions share
+// a budget, and once it runs out (which fails the reduction it ran out in) the rest of the configurations are left as
+// they are
+struct Specializer
+{
+    Reducer reducer;
+    TermIndex configurations; // configurations that failed to be specialized map to NO_SYMBOL
+    List<Statement> specializations;
+
+    static Specializer allocate(DefinitionTable definitions)
+    {
+        Specializer result;
+        result.reducer = Reducer::construct(definitions);
+        result.reducer.steps_left = SPECIALIZATION_STEPS_BUDGET;
+        result.configurations = TermIndex::allocate();
+        result.specializations = List<Statement>::allocate();
+        return result;
+    }
+
+    // doesn't deallocate the specializations
+    void deallocate() { configurations.deallocate(); }
+
+    // takes ownership of the expression
+    Expression* specialize(Expression* expression)
+    {
+        switch (expression->type)
+        {
+            case ExpressionTypeVariable: return expression;
+            case ExpressionTypeFunction:
+                expression = make_unique(expression);
+                expression->body = specialize(expression->body);
+                expression->parameter_usage = ParameterUsageUnknown;
+                return rehash(expression);
+            case ExpressionTypeApplication: return specialize_application(expression);
+            default: assert(false); return {};
+        }
+    }
+
+private:
+    Expression* specialize_application(Expression* expression)
+    {
+        // the arguments end up in reverse order
+        auto arguments = List<Expression*>::allocate();
+        auto depth = expression->depth;
+        auto head = expression;
+        while (head->type == ExpressionTypeApplication)
+        {
+            auto application = take(head);
+            arguments.push(application.right);
+            head = application.left;
+        }
+
+        u64 known_arguments_count = 0;
+        auto is_definition = head->type == ExpressionTypeVariable && reducer.find_definition(head) != nullptr;
+        if (is_definition)
+        {
+            while (known_arguments_count != arguments.size
+                && is_closed(*arguments.data[arguments.size - known_arguments_count - 1]))
+            {
+                known_arguments_count++;
+            }
+        }
+
+        auto result = head;
+        u64 position = 0;
+        if (known_arguments_count != 0)
+        {
+            auto configuration = head;
+            for (u64 i = 0; i < known_arguments_count; i++)
+            {
+                configuration = make_application(depth, configuration, arguments.data[arguments.size - i - 1]);
+            }
+            auto specialization = get_specialization(configuration);
+            if (specialization == NO_SYMBOL)
+            { // the known arguments still get a chance to have their own applications specialized
+                result = specialize_arguments(configuration, known_arguments_count);
+            }
+            else
+            {
+                Expression variable;
+                variable.type = ExpressionTypeVariable;
+                variable.depth = depth;
+                variable.is_bound = false;
+                variable.global_name = specialization;
+                variable.definition = nullptr;
+                drop(configuration);
+                result = to_node(variable);
+            }
+            position = known_arguments_count;
+        }
+        else { result = specialize(head); }
+
+        for (u64 i = position; i < arguments.size; i++)
+        {
+            result = make_application(depth, result, specialize(arguments.data[arguments.size - i - 1]));
+        }
+        arguments.deallocate();
+        return result;
+    }
+
+    // takes ownership of the application, specializes its last `count` arguments
+    Expression* specialize_arguments(Expression* application, u64 count)
+    {
+        if (count == 0) { return application; }
+        application = make_unique(application);
+        application->left = specialize_arguments(application->left, count - 1);
+        application->right = specialize(application->right);
+        return rehash(application);
+    }
+
+    // borrows the configuration, returns NO_SYMBOL if it couldn't be specialized
+    Symbol get_specialization(Expression* configuration)
+    {
+        auto maybe_name = configurations.find(configuration);
+        if (maybe_name.has_data) { return maybe_name.value; }
+
+        auto name = NO_SYMBOL;
+        if (reducer.steps_left == 0)
+        {
+            configurations.add(configuration, name);
+            return name;
+        }
+        auto reducing_result = reducer.reduce_in_place(dup(configuration));
+        if (!reducing_result.is_success) { reducing_result.error.deallocate(); }
+        else if (get_size(*reducing_result.value) > SPECIALIZATION_SIZE_LIMIT) { drop(reducing_result.value); }
+        else
+        {
+            auto head = configuration;
+            while (head->type == ExpressionTypeApplication) { head = head->left; }
+            name = generate_symbol(head->global_name, specializations.size + 1);
+            Statement specialization;
+            specialization.name = name;
+            specialization.expression = take(reducing_result.value);
+            specializations.push(specialization);
+        }
+        configurations.add(configuration, name);
+        return name;
+    }
+
+    static Expression* make_application(u32 depth, Expression* left, Expression* right)
+    {
+        Expression result;
+        result.type = ExpressionTypeApplication;
+        result.depth = depth;
+        result.left = left;
+        result.right = right;
+        return to_node(result);
+    }
+};
+
+// the specialized definitions are added to the end of the program; only the definitions that the root reaches are
+// specialized, since every specialization costs a reduction and the rest of a large library would never pay it back
+void run_specialization_pass(List<Statement>* program, Symbol root)
+{
+    auto definitions = DefinitionTable::build(*program);
+    mark_recursive_definitions(definitions);
+    auto maybe_root_index = definitions.index.get(root);
+    auto graph = DependencyGraph::allocate(definitions);
+    if (maybe_root_index.has_data) { graph.visit(maybe_root_index.value); }
+    auto specializer = Specializer::allocate(definitions);
+    for (u64 i = 0; i < program->size; i++)
+    {
+        if (graph.indices[i] == NOT_VISITED) { continue; }
+        program->data[i].expression = take(specializer.specialize(to_node(program->data[i].expression)));
+    }
+    for (u64 i = 0; i < graph.recursive_groups.size; i++) { graph.recursive_groups.data[i].deallocate(); }
+    graph.recursive_groups.deallocate();
+    graph.order.deallocate();
+    graph.deallocate();
+    for (u64 i = 0; i < specializer.specializations.size; i++) { program->push(specializer.specializations.data[i]); }
+    specializer.specializations.deallocate();
+    specializer.deallocate();
+    definitions.deallocate();
+}
+
+// pre-reduction
+
+const u64 PRE_NORMALIZATION_SIZE_LIMIT = 256;
+
+// definitions that don't refer to any globals can be reduced to their normal forms right away, without knowing anything
+// about the rest of the program; the ones that don't have a normal form are left as they are
+//
+// definitions that the profile says are hot get normalized as well, globals and all, which is what the reducer would
+// have done the first time they were unfolded anyway (see Reducer::unfold), but this way the passes that come after
+// get to see the normal forms; ones that grow past PRE_NORMALIZATION_SIZE_LIMIT are kept as they are, since that's
+// cheaper to unfold than a huge normal form
+void run_pre_reduction_pass(List<Statement> program, Profile* profile)
+{
+    auto definitions = DefinitionTable::build(program);
+    auto reducer = Reducer::construct(definitions);
+    for (u64 i = 0; i < program.size; i++)
+    {
+        auto statement = &program.data[i];
+        auto is_closed = !has_global_variables(statement->expression);
+        if (!is_closed && (profile == nullptr || !profile->is_hot(statement->name))) { continue; }
+        auto reducing_result = is_closed
+            ? reduce_in_place(to_node(copy(statement->expression)))
+            : reducer.reduce_in_place(dup(definitions.entries.data[i].node));
+        if (!reducing_result.is_success)
+        {
+            reducing_result.error.deallocate();
+            continue;
+        }
+        auto normal_form = reducing_result.value;
+        if (!is_closed && get_size(*normal_form) > max(get_size(statement->expression), PRE_NORMALIZATION_SIZE_LIMIT))
+        {
+            drop(normal_form);
+            continue;
+        }
+        statement->expression.deallocate();
+        statement->expression = take(normal_form);
+    }
+    definitions.deallocate();
+}
+
+// eta contraction
+
+// takes ownership of the expression, replaces every `\ x . f x` in it with `f` (as long as `f` doesn't use `x`)
+Expression* eta_contract(Expression* expression)
+{
+    switch (expression->type)
+    {
+        case ExpressionTypeVariable: return expression;
+        case ExpressionTypeFunction:
+            expression = make_unique(expression);
+            expression->body = eta_contract(expression->body);
+            expression->parameter_usage = ParameterUsageUnknown;
+            return eta_reduce(rehash(expression));
+        case ExpressionTypeApplication:
+            expression = make_unique(expression);
+            expression->left = eta_contract(expression->left);
+            expression->right = eta_contract(expression->right);
+            return rehash(expression);
+        default: assert(false); return {};
+    }
+}
+
+void run_eta_contraction_pass(List<Statement> program)
+{
+    for (u64 i = 0; i < program.size; i++)
+    {
+        program.data[i].expression = take(eta_contract(to_node(program.data[i].expression)));
+    }
+}
+
+// unused parameter elimination
+
+// checks that every usage of the global is applied to at least `arguments_count` arguments
+bool is_always_applied(Symbol name, u64 arguments_count, Expression expression)
+{
+    switch (expression.type)
+    {
+        case ExpressionTypeVariable: return expression.is_bound || expression.global_name != name;
+        case ExpressionTypeFunction: return is_always_applied(name, arguments_count, *expression.body);
+        case ExpressionTypeApplication:
+        {
+            auto head = expression;
+            u64 head_arguments_count = 0;
+            while (head.type == ExpressionTypeApplication)
+            {
+                if (!is_always_applied(name, arguments_count, *head.right)) { return false; }
+                head = *head.left;
+                head_arguments_count++;
+            }
+            if (head.type == ExpressionTypeVariable && !head.is_bound && head.global_name == name)
+            {
+                return head_arguments_count >= arguments_count;
+            }
+            return is_always_applied(name, arguments_count, head);
+        }
+        default: assert(false); return {};
+    }
+}
+
+// takes ownership of the expression, removes arguments at the unused positions from all applications of the global
+Expression* remove_unused_arguments(Symbol name, bool* is_parameter_unused, u64 parameters_count, Expression* expression)
+{
+    switch (expression->type)
+    {
+        case ExpressionTypeVariable: return expression;
+        case ExpressionTypeFunction:
+            expression = make_unique(expression);
+            expression->body = remove_unused_arguments(name, is_parameter_unused, parameters_count, expression->body);
+            expression->parameter_usage = ParameterUsageUnknown;
+            return rehash(expression);
+        case ExpressionTypeApplication:
+        {
+            // the arguments end up in reverse order
+            auto arguments = List<Expression*>::allocate();
+            auto depth = expression->depth;
+            auto head = expression;
+            while (head->type == ExpressionTypeApplication)
+            {
+                auto application = take(head);
+                arguments.push(application.right);
+                head = application.left;
+            }
+
+            auto is_usage = head->type == ExpressionTypeVariable && !head->is_bound && head->global_name == name;
+            if (!is_usage) { head = remove_unused_arguments(name, is_parameter_unused, parameters_count, head); }
+            auto result = head;
+            for (u64 i = arguments.size; i != 0; i--)
+            {
+                auto position = arguments.size - i;
+                auto argument = arguments.data[i - 1];
+                if (is_usage && position < parameters_count && is_parameter_unused[position])
+                {
+                    drop(argument);
+                    continue;
+                }
+                Expression application;
+                application.type = ExpressionTypeApplication;
+                application.depth = depth;
+                application.left = result;
+                application.right = remove_unused_arguments(name, is_parameter_unused, parameters_count, argument);
+                result = to_node(application);
+            }
+            arguments.deallocate();
+            return result;
+        }
+        default: assert(false); return {};
+    }
+}
+
+// takes ownership of the function, removes the binders of the unused parameters from its head
+Expression* remove_unused_parameters(bool* is_parameter_unused, u64 position, u64 parameters_count, Expression* function)
+{
+    if (position == parameters_count) { return function; }
+    if (is_parameter_unused[position])
+    {
+        auto body = fix_bound_indices_after_eta_reduction(0, take(function).body);
+        return remove_unused_parameters(is_parameter_unused, position + 1, parameters_count, body);
+    }
+    function = make_unique(function);
+    function->body = remove_unused_parameters(is_parameter_unused, position + 1, parameters_count, function->body);
+    function->parameter_usage = ParameterUsageUnknown;
+    return rehash(function);
+}
+
+// parameters that a definition never uses are removed from it, along with the arguments passed to them; this can only
+// be done when the definition is applied to all of those arguments everywhere it's used, and it changes the meaning of
+// the definition itself, which is why the root is never touched
+void run_unused_parameter_elimination_pass(List<Statement> program, Symbol root)
+{
+    auto is_parameter_unused = List<bool>::allocate();
+    for (u64 i = 0; i < program.size; i++)
+    {
+        auto statement = program.data[i];
+        if (statement.name == root) { continue; }
+
+        is_parameter_unused.size = 0;
+        u64 last_unused_parameter_position = 0;
+        auto has_unused_parameters = false;
+        auto function = statement.expression;
+        while (function.type == ExpressionTypeFunction)
+        {
+            auto is_unused = !has_usages(0, *function.body);
+            if (is_unused)
+            {
+                last_unused_parameter_position = is_parameter_unused.size;
+                has_unused_parameters = true;
+            }
+            is_parameter_unused.push(is_unused);
+            function = *function.body;
+        }
+        if (!has_unused_parameters) { continue; }
+
+        auto parameters_count = last_unused_parameter_position + 1;
+        auto is_applied_everywhere = true;
+        for (u64 j = 0; j < program.size && is_applied_everywhere; j++)
+        {
+            is_applied_everywhere = is_always_applied(statement.name, parameters_count, program.data[j].expression);
+        }
+        if (!is_applied_everywhere) { continue; }
+
+        for (u64 j = 0; j < program.size; j++)
+        {
+            auto expression = to_node(program.data[j].expression);
+            expression = remove_unused_arguments(statement.name, is_parameter_unused.data, parameters_count, expression);
+            program.data[j].expression = take(expression);
+        }
+        auto expression = to_node(program.data[i].expression);
+        expression = remove_unused_parameters(is_parameter_unused.data, 0, parameters_count, expression);
+        program.data[i].expression = take(expression);
+    }
+    is_parameter_unused.deallocate();
+}
+
+// runs the enabled passes over the program in order, returns how much each of them shrank it
+List<OptimizationPassReport> optimize(List<Statement>* program, OptimizationSettings settings)
+{
+    auto result = List<OptimizationPassReport>::allocate();
+    for (u64 i = 0; i < OPTIMIZATION_PASSES_COUNT; i++)
+    {
+        if (!settings.is_pass_enabled[i]) { continue; }
+        OptimizationPassReport report;
+        report.pass = (OptimizationPass)i;
+        report.size_before = get_size(*program);
+        switch (report.pass)
+        {
+            case OptimizationPassInlining: run_inlining_pass(*program, settings.profile); break;
+            case OptimizationPassSpecialization: run_specialization_pass(program, settings.root); break;
+            case OptimizationPassPreReduction: run_pre_reduction_pass(*program, settings.profile); break;
+            case OptimizationPassEtaContraction: run_eta_contraction_pass(*program); break;
+            case OptimizationPassUnusedParameterElimination:
+                run_unused_parameter_elimination_pass(*program, settings.root);
+                break;
+            default: assert(false);
+        }
+        report.size_after = get_size(*program);
+        result.push(report);
+    }
+    return result;
+}
@@ -0,0 +1,162 @@
+// parses the statements of a source on several threads at once: the source gets split into chunks of whole statements
+// after a StatementsScan, and every thread tokenizes and parses a chunk of its own; the statements and the errors are
+// the same as the ones that parsing on a single thread gives
+//
+// parameter IDs have to be unique across the chunks, and since every parameter takes up at least a character of the
+// source, each chunk gets the IDs from its offset in the source onwards
+
+struct StatementsChunk
+{
+    String source; // a part of the whole source
+    u64 offset; // of the chunk in the whole source
+    u64 first_statement_index;
+    SymbolIndex global_names; // shared between the chunks
+    ParserChunk parser_chunk;
+    TermHeap heap; // the nodes of the chunk's statements get allocated from this one, see get_thread_term_heap
+
+    // set by parse_statements_chunk
+    bool is_tokenization_failed;
+    u64 failed_at_index; // in the whole source, if tokenization failed
+    List<Statement> statements;
+    bool is_parsing_failed; // at the statement right after the ones in `statements`
+    String error; // if parsing failed
+};
+
+void parse_statements_chunk(void* passed_chunk)
+{
+    auto chunk = (StatementsChunk*)passed_chunk;
+    thread_term_heaps.set(&chunk->heap);
+    chunk->statements = List<Statement>::allocate();
+    chunk->is_parsing_failed = false;
+    auto tokenization_result = tokenize(chunk->source);
+    chunk->is_tokenization_failed = !tokenization_result.success;
+    if (tokenization_result.success)
+    {
+        auto parser = ExpressionParser::allocate_for_chunk(
+            chunk->source,
+            tokenization_result.tokens,
+            chunk->global_names,
+            chunk->first_statement_index,
+            &chunk->parser_chunk
+        );
+        while (!parser.is_done())
+        {
+            auto statement_result = parser.parse_statement();
+            if (!statement_result.is_success)
+            {
+                chunk->is_parsing_failed = true;
+                chunk->error = statement_result.error;
+                break;
+            }
+            chunk->statements.push(statement_result.value);
+        }
+        parser.deallocate();
+        tokenization_result.deallocate();
+    }
+    else { chunk->failed_at_index = chunk->offset + tokenization_result.failed_at_index; }
+    thread_term_heaps.set(nullptr); // threads can run on the main one, see spawn_thread
+}
+
+// the error is the whole message to report, unlike with parse_statements
+ParseStatementsResult parse_statements_in_parallel(String source, u32 threads_count)
+{
+    if (source.size > MAX_SOURCE_SIZE)
+    {
+        return ParseStatementsResult::make_fail(make_tokenization_error(MAX_SOURCE_SIZE));
+    }
+    assert((u64)next_id + source.size <= (u32)-1, "parse_statements_in_parallel: ran out of parameter IDs");
+
+    auto scan = StatementsScan::scan(source);
+    auto symbol_table_lock = Lock::construct();
+    auto chunks = List<StatementsChunk>::allocate();
+    auto target_chunk_size = max(source.size / max(threads_count, (u32)1), (u64)1);
+    u64 chunk_first_statement_index = 0;
+    for (u64 i = 0; i < scan.statements.size; i++)
+    {
+        auto chunk_offset = scan.statements.data[chunk_first_statement_index].offset;
+        auto chunk_end = scan.statements.data[i].offset + scan.statements.data[i].size;
+        if (chunk_end - chunk_offset < target_chunk_size && i + 1 != scan.statements.size) { continue; }
+        StatementsChunk chunk;
+        chunk.source.data = source.data + chunk_offset;
+        chunk.source.size = chunk_end - chunk_offset;
+        chunk.source.capacity = chunk.source.size;
+        chunk.offset = chunk_offset;
+        chunk.first_statement_index = chunk_first_statement_index;
+        chunk.global_names = scan.names;
+        chunk.parser_chunk = ParserChunk::allocate(next_id + chunk_offset, &symbol_table_lock);
+        chunk.heap = make_thread_term_heap();
+        chunks.push(chunk);
+        chunk_first_statement_index = i + 1;
+    }
+
+    thread_term_heaps.allocate(); // before any of the threads get to it
+    auto threads = List<Thread>::allocate();
+    for (u64 i = 1; i < chunks.size; i++)
+    {
+        auto maybe_thread = spawn_thread(parse_statements_chunk, &chunks.data[i]);
+        if (maybe_thread.has_data) { threads.push(maybe_thread.value); }
+        else { parse_statements_chunk(&chunks.data[i]); }
+    }
+    if (chunks.size != 0) { parse_statements_chunk(&chunks.data[0]); } // the main thread would be idle otherwise
+    for (u64 i = 0; i < threads.size; i++) { join_thread(threads.data[i]); }
+    threads.deallocate();
+    next_id += source.size;
+
+    // tokenization goes over the whole source before parsing starts, so its errors come first, and a duplicate is
+    // found before its statement gets parsed
+    auto is_tokenization_failed = false;
+    u64 failed_at_index = 0;
+    auto failed_statement_index = scan.has_duplicate ? scan.duplicate_statement_index : (u64)-1;
+    StatementsChunk* failed_chunk = nullptr;
+    u64 merged_statements_count = 0;
+    for (u64 i = 0; i < chunks.size; i++)
+    {
+        auto chunk = &chunks.data[i];
+        term_heap.adopt(&chunk->heap);
+        chunk->parser_chunk.deallocate();
+        merged_statements_count += chunk->statements.size;
+        if (chunk->is_tokenization_failed && !is_tokenization_failed)
+        {
+            is_tokenization_failed = true;
+            failed_at_index = chunk->failed_at_index;
+        }
+        auto chunk_failed_statement_index = chunk->first_statement_index + chunk->statements.size;
+        if (chunk->is_parsing_failed && chunk_failed_statement_index < failed_statement_index)
+        {
+            failed_statement_index = chunk_failed_statement_index;
+            failed_chunk = chunk;
+        }
+    }
+
+    String error;
+    if (is_tokenization_failed) { error = make_tokenization_error(failed_at_index); }
+    else if (failed_chunk != nullptr)
+    {
+        error = String::allocate();
+        error.push("Parsing failed: ");
+        error.push(failed_chunk->error);
+    }
+    else if (scan.has_duplicate) { error = scan.make_duplicate_error(); }
+    auto fail = is_tokenization_failed || failed_chunk != nullptr || scan.has_duplicate;
+    scan.deallocate();
+
+    auto statements = List<Statement>::allocate(max(merged_statements_count, (u64)1));
+    for (u64 i = 0; i < chunks.size; i++)
+    {
+        auto chunk = chunks.data[i];
+        for (u64 j = 0; j < chunk.statements.size; j++)
+        {
+            if (fail) { chunk.statements.data[j].deallocate(); }
+            else { statements.push(chunk.statements.data[j]); }
+        }
+        chunk.statements.deallocate();
+        if (chunk.is_parsing_failed) { chunk.error.deallocate(); }
+    }
+    chunks.deallocate();
+    if (fail)
+    {
+        statements.deallocate();
+        return ParseStatementsResult::make_fail(error);
+    }
+    return ParseStatementsResult::make_success(statements);
+}
@@ -5,10 +5,23 @@ enum ExpressionType
     ExpressionTypeApplication,
 };
 
+// how many times a function's parameter is used in its body, see get_parameter_usage
+enum ParameterUsage
+{
+    ParameterUsageUnknown, // hasn't been computed yet
+    ParameterUsageNone,
+    ParameterUsageOnce,
+    ParameterUsageMany,
+};
+
+struct Definition;
+
 struct Expression
 {
     ExpressionType type;
     u32 depth; // for keeping track of the nestedness level
+    u32 reference_count; // only meaningful for nodes on the heap, see to_node
+    u64 hash; // only meaningful for nodes on the heap, see compute_hash
 
     union
     {
@@ -20,7 +33,8 @@ struct Expression
             u32 bounded_id;
             u32 bound_index;
             // is_bound = false
-            String global_name;
+            Symbol global_name;
+            Definition* definition; // not owned, nullptr until linked by DefinitionTable::build
         };
         // ExpressionTypeFunction
         struct
@@ -28,8 +42,10 @@ struct Expression
             // this is just a simple way to refer to a function in an expression
             // (used for expression to string conversion)
             u32 parameter_id;
-            String parameter_name;
+            Symbol parameter_name;
             Expression* body;
+            ParameterUsage parameter_usage; // cached, has to be reset whenever the body gets reduced
+            bool is_parameter_strict; // see analyze_strictness
         };
         // ExpressionTypeApplication
         struct { Expression* left; Expression* right; };
@@ -39,32 +55,116 @@ struct Expression
     String to_string();
 };
 
+void drop(Expression* node);
+
 void Expression::deallocate()
 {
     switch (type)
     {
-        case ExpressionTypeVariable:
-            if (!is_bound) { global_name.deallocate(); }
-            break;
+        case ExpressionTypeVariable: break;
         case ExpressionTypeFunction:
-            parameter_name.deallocate();
-            body->deallocate();
-            default_deallocate(body);
+            drop(body);
             break;
         case ExpressionTypeApplication:
-            left->deallocate();
-            right->deallocate();
-            default_deallocate(left);
-            default_deallocate(right);
+            drop(left);
+            drop(right);
             break;
         default: assert(false);
     }
 }
 
+u64 combine_hashes(u64 left, u64 right)
+{
+    // finalizer of splitmix64, so that similar inputs don't end up with similar hashes
+    auto result = left ^ (right + 0x9e3779b97f4a7c15 + (left << 6) + (left >> 2));
+    result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9;
+    result = (result ^ (result >> 27)) * 0x94d049bb133111eb;
+    return result ^ (result >> 31);
+}
+
+// structural hash of the expression that's computed from de Bruijn indices rather than parameter names, so
+// alpha-equivalent expressions get the same hash; it only looks at the hashes stored in the child nodes, which means
+// nodes can keep their hashes up to date as the terms are built: to_node computes it for new nodes, and code that
+// modifies a node in place has to call rehash after it's done
+u64 compute_hash(Expression expression)
+{
+    switch (expression.type)
+    {
+        case ExpressionTypeVariable:
+            return expression.is_bound
+                ? combine_hashes(1, expression.bound_index)
+                : combine_hashes(2, expression.global_name);
+        case ExpressionTypeFunction:
+            // the body can be missing while the parser is still building the function, see parse_function
+            return expression.body == nullptr ? 0 : combine_hashes(3, expression.body->hash);
+        case ExpressionTypeApplication:
+            return combine_hashes(combine_hashes(4, expression.left->hash), expression.right->hash);
+        default: assert(false); return {};
+    }
+}
+
+Expression* rehash(Expression* node)
+{
+    node->hash = compute_hash(*node);
+    return node;
+}
+
+// expression nodes on the heap are immutable and shared between terms, every Expression value owns one reference to
+// each of its child nodes; a node may only be modified in place when its reference count is 1
+Expression* to_node(Expression expression)
+{
+    expression.reference_count = 1;
+    expression.hash = compute_hash(expression);
+    auto node = (Expression*)get_thread_term_heap()->allocate(sizeof(Expression));
+    *node = expression;
+    return node;
+}
+
+// frees the node itself without touching the nodes it references
+void free_node(Expression* node)
+{
+    get_thread_term_heap()->deallocate(node);
+}
+
+Expression* dup(Expression* node)
+{
+    node->reference_count++;
+    return node;
+}
+
+// applications nest along their left side and chains of functions along their bodies, and either can be as long as the
+// source makes them, so those children are dropped in a loop rather than recursively
+void drop(Expression* node)
+{
+    while (true)
+    {
+        assert(node->reference_count != 0, "drop: expression node has already been freed");
+        node->reference_count--;
+        if (node->reference_count != 0) { return; }
+        Expression* next_node;
+        switch (node->type)
+        {
+            case ExpressionTypeVariable: next_node = nullptr; break;
+            case ExpressionTypeFunction: next_node = node->body; break;
+            case ExpressionTypeApplication:
+                drop(node->right);
+                next_node = node->left;
+                break;
+            default: assert(false); return;
+        }
+        free_node(node);
+        if (next_node == nullptr) { return; }
+        node = next_node;
+    }
+}
+
+// child nodes are shared with the source rather than copied
 Expression copy(Expression source)
 {
     Expression result;
     result.type = source.type;
+    result.depth = source.depth;
+    result.hash = source.hash;
     switch (source.type)
     {
         case ExpressionTypeVariable:
@@ -76,51 +176,85 @@ Expression copy(Expression source)
             }
             else
             {
-                result.global_name = source.global_name.copy();
+                result.global_name = source.global_name;
+                result.definition = source.definition;
             }
             return result;
         case ExpressionTypeFunction:
             result.parameter_id = source.parameter_id;
-            result.parameter_name = source.parameter_name.copy();
-            result.body = copy_to_heap(copy(*source.body));
+            result.parameter_name = source.parameter_name;
+            result.body = dup(source.body);
+            result.parameter_usage = source.parameter_usage;
+            result.is_parameter_strict = source.is_parameter_strict;
             return result;
         case ExpressionTypeApplication:
-            result.left = copy_to_heap(copy(*source.left));
-            result.right = copy_to_heap(copy(*source.right));
+            result.left = dup(source.left);
+            result.right = dup(source.right);
             return result;
         default: assert(false); return {};
     }
 }
 
-static bool operator==(Expression left, Expression right)
+// takes ownership of the node and turns it back into a value
+Expression take(Expression* node)
 {
-    if (left.type != right.type) { return false; }
-    switch (left.type)
+    if (node->reference_count == 1)
+    {
+        auto result = *node;
+        free_node(node);
+        return result;
+    }
+    auto result = copy(*node);
+    drop(node);
+    return result;
+}
+
+// takes ownership of the node and returns one with the same contents that can be modified in place, which is the same
+// node if nobody else is referencing it
+Expression* make_unique(Expression* node)
+{
+    if (node->reference_count == 1) { return node; }
+    auto result = to_node(copy(*node));
+    drop(node);
+    return result;
+}
+
+// nodes with different hashes can't be equal, so most of the time a mismatch is found without walking the expressions
+bool are_equal(Expression* left, Expression* right)
+{
+    if (left == right) { return true; }
+    if (left->hash != right->hash || left->type != right->type) { return false; }
+    switch (left->type)
     {
         case ExpressionTypeVariable:
-            return left.is_bound == right.is_bound && (
-                left.is_bound
-                    ? left.bound_index == right.bound_index
-                    : left.global_name == right.global_name
+            return left->is_bound == right->is_bound && (
+                left->is_bound
+                    ? left->bound_index == right->bound_index
+                    : left->global_name == right->global_name
             );
-        case ExpressionTypeFunction: return *left.body == *right.body;
-        case ExpressionTypeApplication: return *left.left == *right.left && *left.right == *right.right;
+        case ExpressionTypeFunction: return are_equal(left->body, right->body);
+        case ExpressionTypeApplication:
+            return are_equal(left->left, right->left) && are_equal(left->right, right->right);
         default: assert(false, "Unknown expression type encountered"); return {};
     }
 }
 
+// the hash of an expression value isn't stored anywhere (unlike with nodes), but it's cheap to compute
+static bool operator==(Expression left, Expression right)
+{
+    left.hash = compute_hash(left);
+    right.hash = compute_hash(right);
+    return are_equal(&left, &right);
+}
+
 static bool operator!=(Expression left, Expression right) { return !(left == right); }
 
 struct Statement
 {
-    String name;
+    Symbol name;
     Expression expression;
 
-    void deallocate()
-    {
-        name.deallocate();
-        expression.deallocate();
-    }
+    void deallocate() { expression.deallocate(); }
 };
 
 String to_string(List<Statement> statements)
@@ -129,7 +263,7 @@ String to_string(List<Statement> statements)
     for (u64 i = 0; i < statements.size; i++)
     {
         auto statement = statements.data[i];
-        result.push(statement.name);
+        result.push(symbol_table.get_name(statement.name));
         result.push(" = ");
 
         auto expression_string = statement.expression.to_string();
@@ -143,7 +277,7 @@ String to_string(List<Statement> statements)
 
 struct BoundedVariableUsageMapEntry
 {
-    String variable_name;
+    Symbol variable_name;
     u32 variable_id;
 };
 
@@ -163,7 +297,7 @@ struct BoundedVariableUsageMap
         entries.deallocate();
     }
 
-    void add(String variable_name, u32 variable_id)
+    void add(Symbol variable_name, u32 variable_id)
     {
         BoundedVariableUsageMapEntry entry;
         entry.variable_name = variable_name;
@@ -171,7 +305,7 @@ struct BoundedVariableUsageMap
         entries.push(entry);
     }
 
-    String get_name(u32 variable_id)
+    Symbol get_name(u32 variable_id)
     {
         for (u64 i = 0; i < entries.size; i++)
         {
@@ -184,7 +318,7 @@ struct BoundedVariableUsageMap
         return {};
     }
 
-    u32 get_duplicates_count(u32 variable_id, String variable_name)
+    u32 get_duplicates_count(u32 variable_id, Symbol variable_name)
     {
         auto duplicates_count = 0;
         for (u64 i = 0; i < entries.size; i++)
@@ -205,7 +339,7 @@ struct BoundedVariableUsageMap
 
 struct GlobalVariableNamesMapEntry
 {
-    String name;
+    Symbol name;
     u32 function_id; // use function's parameter ID
 };
 
@@ -222,7 +356,7 @@ struct GlobalVariableNamesMap
 
     void deallocate() { entries.deallocate(); }
 
-    void push(String name, u32 function_id)
+    void push(Symbol name, u32 function_id)
     {
         if (!has(name, function_id))
         {
@@ -233,7 +367,7 @@ struct GlobalVariableNamesMap
         }
     }
 
-    bool has(String name, u32 function_id)
+    bool has(Symbol name, u32 function_id)
     {
         for (u64 i = 0; i < entries.size; i++)
         {
@@ -339,7 +473,7 @@ void ExpressionToStringConverter::internal_convert(Expression expression)
                 ? bounded_variable_usage_map.get_name(expression.bounded_id)
                 : expression.global_name;
 
-            result.push(name);
+            result.push(symbol_table.get_name(name));
 
             if (expression.is_bound) // global variables are going to be prioritized so that they always have their name printed unchanged
             {
@@ -366,7 +500,7 @@ void ExpressionToStringConverter::internal_convert(Expression expression)
             auto next_node = &expression;
             do
             {
-                result.push(next_node->parameter_name);
+                result.push(symbol_table.get_name(next_node->parameter_name));
 
                 bounded_variable_usage_map.add(next_node->parameter_name, next_node->parameter_id);
 
@@ -420,121 +554,184 @@ void ExpressionToStringConverter::internal_convert(Expression expression)
     assert(false);
 }
 
-Expression append_left_to_application(u32 depth, Expression node_to_append, Expression* application_tree)
-{
-    if (application_tree->left->type == ExpressionTypeApplication && application_tree->left->depth == depth)
-    {
-        append_left_to_application(depth, node_to_append, application_tree->left);
-    }
-    else
-    {
-        Expression new_left;
-        new_left.type = ExpressionTypeApplication;
-        new_left.depth = depth;
-        new_left.left = copy_to_heap(node_to_append);
-        new_left.right = application_tree->left;
-
-        application_tree->left = copy_to_heap(new_left);
-    }
-    return *application_tree;
-}
-
 struct BoundedVariableMapEntry
 {
     u32 id;
-    String name;
+    Symbol name;
 };
 
+// parameters in scope, the innermost one is last; names can't be shadowed, so every name is in the list at most once,
+// which lets the index map names to positions in the list without ever removing anything from it: entries of names
+// that went out of scope point past the end of the list or at a different name
 struct BoundedVariableMap
 {
     List<BoundedVariableMapEntry> list;
+    SymbolIndex positions;
 
     static BoundedVariableMap allocate()
     {
         BoundedVariableMap result;
         result.list = List<BoundedVariableMapEntry>::allocate();
+        result.positions = SymbolIndex::allocate();
         return result;
     }
 
     void deallocate()
     {
         list.deallocate();
+        positions.deallocate();
     }
 
-    void push(u32 id, String name)
+    void push(u32 id, Symbol name)
     {
         BoundedVariableMapEntry entry;
         entry.id = id;
         entry.name = name;
+        positions.set(name, list.size);
         list.push(entry);
     }
 
-    bool has(String name)
+    bool has(Symbol name)
     {
-        for (u64 i = 0; i < list.size; i++)
-        {
-            if (list.data[i].name == name)
-            {
-                return true;
-            }
-        }
-        return false;
+        auto maybe_position = positions.get(name);
+        return maybe_position.has_data
+            && maybe_position.value < list.size
+            && list.data[maybe_position.value].name == name;
     }
 
-    u32 get(String name)
+    u32 get(Symbol name)
     {
-        for (u64 i = 0; i < list.size; i++)
-        {
-            if (list.data[i].name == name)
-            {
-                return list.data[i].id;
-            }
-        }
-        assert(false);
-        return {};
+        assert(has(name));
+        return list.data[positions.get(name).value].id;
     }
 
-    u32 get_index(String name)
+    u32 get_index(Symbol name)
     {
-        for (u64 i = 0; i < list.size; i++)
-        {
-            if (list.data[i].name == name)
-            {
-                return i;
-            }
-        }
-        assert(false);
-        return {};
+        assert(has(name));
+        return positions.get(name).value;
     }
 
     void clear() { list.clear(); }
 };
 
+enum ParserFrameType
+{
+    ParserFrameTypeParenthesized,
+    ParserFrameTypeFunction,
+};
+
+// an expression that's been opened but not closed yet, see ExpressionParser::parse_expression
+struct ParserFrame
+{
+    ParserFrameType type;
+    Expression* applied; // what the expression is going to be the last argument of once it's closed, nullptr if nothing
+    // ParserFrameTypeFunction
+    u64 first_function_index; // the function's nodes are in ExpressionParser::functions starting from this one
+    u64 bounded_variables_count; // from before the function's parameters came into scope
+};
+
 u32 next_id = 0;
 
+// what a parser that works on a chunk of the source on a thread of its own needs, see parse_statements_in_parallel
+struct ParserChunk
+{
+    u32 next_id; // the chunk's own range of IDs starts here
+    // symbol_table can only be touched while holding the lock, so every name gets interned into a table of the chunk's
+    // own first, which makes it go to symbol_table only once
+    Lock* symbol_table_lock;
+    SymbolTable local_symbols;
+    List<Symbol> global_symbols; // indexed by local symbols
+
+    static ParserChunk allocate(u32 next_id, Lock* symbol_table_lock)
+    {
+        ParserChunk result;
+        result.next_id = next_id;
+        result.symbol_table_lock = symbol_table_lock;
+        result.local_symbols = {};
+        result.global_symbols = List<Symbol>::allocate();
+        return result;
+    }
+
+    void deallocate()
+    {
+        local_symbols.deallocate();
+        global_symbols.deallocate();
+    }
+
+    Symbol intern(StringView name)
+    {
+        auto local_symbol = local_symbols.intern(name);
+        if (local_symbol == global_symbols.size)
+        {
+            symbol_table_lock->acquire();
+            global_symbols.push(symbol_table.intern(name));
+            symbol_table_lock->release();
+        }
+        return global_symbols.data[local_symbol];
+    }
+
+    void push_name(String* target, Symbol name)
+    {
+        symbol_table_lock->acquire();
+        target->push(symbol_table.get_name(name));
+        symbol_table_lock->release();
+    }
+};
+
 struct ExpressionParser
 {
+    String source; // the one the tokens are from
     List<Token> tokens;
     u64 index;
     u32 depth;
     BoundedVariableMap bounded_variable_map;
-    List<String> global_names;
-
-    static ExpressionParser allocate(List<Token> tokens)
+    // maps names of the definitions parsed so far to their statement index, or the names of all of the definitions when
+    // working on a chunk
+    SymbolIndex global_names;
+    u64 statements_count; // started so far, including the one that's being parsed and the ones before the chunk
+    ParserChunk* chunk; // nullptr unless working on a chunk, see ParserChunk
+    List<ParserFrame> frames; // see parse_expression
+    List<Expression*> functions; // nodes of the functions in the frames, in the same order
+
+    static ExpressionParser allocate(String source, List<Token> tokens)
     {
         ExpressionParser result;
+        result.source = source;
         result.tokens = tokens;
         result.index = 0;
         result.depth = 0;
         result.bounded_variable_map = BoundedVariableMap::allocate();
-        result.global_names = List<String>::allocate();
+        result.global_names = SymbolIndex::allocate();
+        result.statements_count = 0;
+        result.chunk = nullptr;
+        result.frames = List<ParserFrame>::allocate();
+        result.functions = List<Expression*>::allocate();
+        return result;
+    }
+
+    // the global names are shared with the parsers of the other chunks, so they aren't owned by this one
+    static ExpressionParser allocate_for_chunk(
+        String source,
+        List<Token> tokens,
+        SymbolIndex global_names,
+        u64 first_statement_index,
+        ParserChunk* chunk
+    )
+    {
+        auto result = allocate(source, tokens);
+        result.global_names.deallocate();
+        result.global_names = global_names;
+        result.statements_count = first_statement_index;
+        result.chunk = chunk;
         return result;
     }
 
     void deallocate()
     {
         bounded_variable_map.deallocate();
-        global_names.deallocate();
+        if (chunk == nullptr) { global_names.deallocate(); } // the ones of chunks are shared between them
+        frames.deallocate();
+        functions.deallocate();
     }
 
     bool is_done() { return index == tokens.size; }
@@ -543,193 +740,187 @@ struct ExpressionParser
 
     void next() { index++; }
 
-    void skip_whitespace() { while (!is_done() && current().type == LcTokenTypeWhitespace) { next(); } }
+    Symbol current_name()
+    {
+        auto text = current().get_text(source);
+        return chunk == nullptr ? symbol_table.intern(text) : chunk->intern(text);
+    }
 
-    bool expect_token_type(LcTokenType token_type)
+    void push_name(String* target, Symbol name)
     {
-        if (is_done() || current().type != token_type) { return false; }
-        next();
-        return true;
+        if (chunk == nullptr) { target->push(symbol_table.get_name(name)); }
+        else { chunk->push_name(target, name); }
     }
 
-    Option<Expression> parse_variable()
+    // whether the name is the one of the statement that's being parsed or of one before it
+    bool is_defined_so_far(Symbol name)
     {
-        if (is_done() || current().type != LcTokenTypeName) { return Option<Expression>::empty(); }
+        auto maybe_statement_index = global_names.get(name);
+        return maybe_statement_index.has_data && maybe_statement_index.value < statements_count;
+    }
 
-        Expression expression;
-        expression.type = ExpressionTypeVariable;
-        expression.depth = depth;
-        expression.is_bound = bounded_variable_map.has(current().name);
-        if (expression.is_bound)
-        {
-            expression.bounded_id = bounded_variable_map.get(current().name);
-            expression.bound_index =
-                bounded_variable_map.list.size - bounded_variable_map.get_index(current().name) - 1;
-        }
-        else
-        {
-            expression.global_name = current().name.copy();
-        }
+    // for error messages
+    const char* describe_current() { return is_done() ? "end of file" : to_string((LcTokenType)current().type); }
 
+    bool expect_token_type(LcTokenType token_type)
+    {
+        if (is_done() || current().type != token_type) { return false; }
         next();
-
-        return Option<Expression>::construct(expression);
+        return true;
     }
 
-    Option<Expression> parse_function()
+    // parses the longest expression that starts at the current token: applications associate to the left, and functions
+    // extend as far to the right as they can; instead of recursing into parentheses and function bodies, the parser
+    // keeps a stack of the expressions that are still open, which makes it look at every token exactly once and lets the
+    // nesting go as deep as memory allows
+    Option<Expression> parse_expression()
     {
-        if (is_done()) { return Option<Expression>::empty(); }
-
-        auto original_index = index;
-        auto original_bounded_variable_map_size = bounded_variable_map.list.size;
-
-        bool head_start_found = expect_token_type(LcTokenTypeLambdaHeadStart);
-        skip_whitespace(); // do it here just to avoid an extra nestedness level
-        if (
-            head_start_found
-                && current().type == LcTokenTypeName
-                && !bounded_variable_map.has(current().name)
-                && !global_names.contains(current().name)
-        )
+        auto original_depth = depth;
+        auto original_bounded_variables_count = bounded_variable_map.list.size;
+        Expression* applied = nullptr; // the innermost open expression as far as it's been parsed
+        auto success = true;
+        while (success)
         {
-            Expression function;
-            function.type = ExpressionTypeFunction;
-            function.depth = depth;
-            function.parameter_id = next_id++;
-            function.parameter_name = current().name.copy();
-            function.body = nullptr;
-            bounded_variable_map.push(function.parameter_id, function.parameter_name);
-            next();
-
-            Expression** next_body = &function.body;
-            bool success = true;
-            while (true)
+            if (!is_done() && current().type == LcTokenTypeName)
             {
-                skip_whitespace();
-
-                if (current().type != LcTokenTypeName) { break; }
-                if (bounded_variable_map.has(current().name)) { success = false; break; }
-
-                Expression next_function;
-                next_function.type = ExpressionTypeFunction;
-                next_function.depth = depth;
-                next_function.parameter_id = next_id++;
-                next_function.parameter_name = current().name.copy();
-                next_function.body = nullptr;
-
-                *next_body = copy_to_heap(next_function);
-                next_body = &(*next_body)->body;
-
-                bounded_variable_map.push(next_function.parameter_id, next_function.parameter_name);
-
+                applied = apply(applied, make_variable());
                 next();
+                continue;
             }
-
-            if (success && expect_token_type(LcTokenTypeLambdaHeadEnd))
+            if (expect_token_type(LcTokenTypeOpenParen))
             {
-                skip_whitespace();
-                auto maybe_body = parse_expression();
-                if (maybe_body.has_data)
-                {
-                    *next_body = copy_to_heap(maybe_body.value);
-                    bounded_variable_map.list.size = original_bounded_variable_map_size;
-                    return Option<Expression>::construct(function);
-                }
+                push_frame(ParserFrameTypeParenthesized, applied);
+                applied = nullptr;
+                depth++;
+                continue;
+            }
+            if (expect_token_type(LcTokenTypeLambdaHeadStart))
+            {
+                push_frame(ParserFrameTypeFunction, applied);
+                applied = nullptr;
+                success = parse_function_head();
+                continue;
             }
 
-            function.parameter_name.deallocate();
-            auto node = function.body;
-            while (node != nullptr)
+            // any other token ends all of the functions that are open, and a closing parenthesis ends the innermost
+            // parenthesized expression as well
+            if (applied == nullptr) { break; }
+            while (frames.size != 0 && frames.data[frames.size - 1].type == ParserFrameTypeFunction)
             {
-                auto next_node = node->body;
-                node->parameter_name.deallocate();
-                default_deallocate(node);
-                node = next_node;
+                applied = close_function(applied);
             }
+            if (frames.size == 0 || !expect_token_type(LcTokenTypeCloseParen)) { break; }
+            frames.size--;
+            depth--;
+            applied = apply(frames.data[frames.size].applied, applied);
         }
 
-        index = original_index;
-        bounded_variable_map.list.size = original_bounded_variable_map_size;
-        return Option<Expression>::empty();
-    }
-
-    Option<Expression> parse_application()
-    {
-        if (is_done()) { return Option<Expression>::empty(); }
+        if (success && applied != nullptr && frames.size == 0) { return Option<Expression>::construct(take(applied)); }
 
-        auto original_index = index;
-
-        auto maybe_left = parse_variable();
-        if (!maybe_left.has_data) { maybe_left = parse_parenthesized_expression(); }
-
-        if (maybe_left.has_data)
+        if (applied != nullptr) { drop(applied); }
+        while (frames.size != 0)
         {
-            skip_whitespace();
-
-            auto maybe_right = parse_expression();
-            if (maybe_right.has_data)
-            {
-                if (maybe_right.value.type == ExpressionTypeApplication && maybe_right.value.depth == depth)
-                {
-                    return Option<Expression>::construct(
-                        append_left_to_application(depth, maybe_left.value, &maybe_right.value)
-                    );
-                }
-                Expression expression;
-                expression.type = ExpressionTypeApplication;
-                expression.depth = depth;
-                expression.left = copy_to_heap(maybe_left.value);
-                expression.right = copy_to_heap(maybe_right.value);
-                return Option<Expression>::construct(expression);
+            auto frame = frames.data[frames.size - 1];
+            frames.pop();
+            if (frame.applied != nullptr) { drop(frame.applied); }
+            if (frame.type == ParserFrameTypeFunction)
+            { // bodies of the functions aren't there yet, so they don't reference anything but each other
+                for (auto i = frame.first_function_index; i < functions.size; i++) { free_node(functions.data[i]); }
+                functions.size = frame.first_function_index;
             }
-
-            maybe_left.value.deallocate();
         }
-
-        index = original_index;
+        depth = original_depth;
+        bounded_variable_map.list.size = original_bounded_variables_count;
         return Option<Expression>::empty();
     }
 
-    Option<Expression> parse_parenthesized_expression()
+private:
+    Expression* make_variable()
     {
-        auto original_index = index;
-        if (expect_token_type(LcTokenTypeOpenParen))
+        auto name = current_name();
+        Expression expression;
+        expression.type = ExpressionTypeVariable;
+        expression.depth = depth;
+        expression.is_bound = bounded_variable_map.has(name);
+        if (expression.is_bound)
         {
-            auto original_depth = depth;
-            depth++;
-            auto maybe_expression = parse_expression();
-            if (maybe_expression.has_data)
-            {
-                if (expect_token_type(LcTokenTypeCloseParen))
-                {
-                    depth--;
-                    return Option<Expression>::construct(maybe_expression.value);
-                }
-                maybe_expression.value.deallocate();
-            }
-            depth = original_depth;
+            expression.bounded_id = bounded_variable_map.get(name);
+            expression.bound_index = bounded_variable_map.list.size - bounded_variable_map.get_index(name) - 1;
         }
-        index = original_index;
-        return Option<Expression>::empty();
+        else
+        {
+            expression.global_name = name;
+            expression.definition = nullptr;
+        }
+        return to_node(expression);
     }
 
-    Option<Expression> parse_expression()
+    // takes ownership of both
+    Expression* apply(Expression* function, Expression* argument)
     {
-        auto maybe_application = parse_application();
-        if (maybe_application.has_data) { return maybe_application; }
+        if (function == nullptr) { return argument; }
+        Expression application;
+        application.type = ExpressionTypeApplication;
+        application.depth = depth;
+        application.left = function;
+        application.right = argument;
+        return to_node(application);
+    }
 
-        auto maybe_variable = parse_variable();
-        if (maybe_variable.has_data) { return maybe_variable; }
+    void push_frame(ParserFrameType type, Expression* applied)
+    {
+        ParserFrame frame;
+        frame.type = type;
+        frame.applied = applied;
+        frame.first_function_index = functions.size;
+        frame.bounded_variables_count = bounded_variable_map.list.size;
+        frames.push(frame);
+    }
 
-        auto maybe_function = parse_function();
-        if (maybe_function.has_data) { return maybe_function; }
+    // parses the parameters of the function on top of the frame stack and the dot after them; `\ x y . body` is
+    // parsed as `\ x . \ y . body`, so every parameter gets its own node, chained through their bodies
+    bool parse_function_head()
+    {
+        auto first_function_index = frames.data[frames.size - 1].first_function_index;
+        while (!is_done() && current().type == LcTokenTypeName)
+        {
+            auto name = current_name();
+            if (bounded_variable_map.has(name)) { return false; }
+            if (functions.size == first_function_index && is_defined_so_far(name)) { return false; }
 
-        auto maybe_parenthesized = parse_parenthesized_expression();
-        if (maybe_parenthesized.has_data) { return maybe_parenthesized; }
+            Expression function;
+            function.type = ExpressionTypeFunction;
+            function.depth = depth;
+            function.parameter_id = chunk == nullptr ? next_id++ : chunk->next_id++;
+            function.parameter_name = name;
+            function.body = nullptr;
+            function.parameter_usage = ParameterUsageUnknown;
+            function.is_parameter_strict = false;
+            auto node = to_node(function);
+            if (functions.size != first_function_index) { functions.data[functions.size - 1]->body = node; }
+            functions.push(node);
+            bounded_variable_map.push(function.parameter_id, function.parameter_name);
+            next();
+        }
+        return functions.size != first_function_index && expect_token_type(LcTokenTypeLambdaHeadEnd);
+    }
 
-        return Option<Expression>::empty();
+    // takes ownership of the body, returns the function applied to whatever came before it
+    Expression* close_function(Expression* body)
+    {
+        auto frame = frames.data[frames.size - 1];
+        frames.pop();
+        functions.data[functions.size - 1]->body = body;
+        // the nodes were put on the heap before their bodies were known, so their hashes have to be computed now, from
+        // the inside out
+        for (auto i = functions.size; i != frame.first_function_index; i--) { rehash(functions.data[i - 1]); }
+        auto function = functions.data[frame.first_function_index];
+        functions.size = frame.first_function_index;
+        bounded_variable_map.list.size = frame.bounded_variables_count;
+        return apply(frame.applied, function);
     }
 
+public:
     Result<Statement, String> parse_statement()
     {
         if (is_done())
@@ -742,73 +933,72 @@ struct ExpressionParser
         {
             auto error = String::allocate();
             error.push("Expected a name as start of a statement, encountered ");
-            error.push(to_string(current().type));
+            error.push(describe_current());
             return Result<Statement, String>::fail(error);
         }
-        auto name = current().name;
-        if (global_names.contains(name))
+        auto name = current_name();
+        // duplicates in chunks are found by whoever collected the names, see parse_statements_in_parallel
+        if (chunk == nullptr)
         {
-            auto error = String::allocate();
-            error.push("Encountered duplicate definition: ");
-            error.push(name);
-            return Result<Statement, String>::fail(error);
+            if (global_names.has(name))
+            {
+                auto error = String::allocate();
+                error.push("Encountered duplicate definition: ");
+                push_name(&error, name);
+                return Result<Statement, String>::fail(error);
+            }
+            global_names.set(name, statements_count);
         }
-        global_names.push(name);
+        statements_count++;
         // we don't need to restore global names in case of failure as long as we know that source can only be a list of
         // statements, and therefore failure to parse a statement will lead to termination of parsing and deallocation
         // of all parser resources
 
         auto original_index = index;
         next();
-        skip_whitespace();
 
         if (!expect_token_type(LcTokenTypeEquals))
         {
-            index = original_index;
             auto error = String::allocate();
             error.push("Expected an equals sign as part of a statement, encountered ");
-            error.push(to_string(current().type));
+            error.push(describe_current());
+            index = original_index;
             return Result<Statement, String>::fail(error);
         }
 
-        skip_whitespace();
-
         auto maybe_expression = parse_expression();
         if (!maybe_expression.has_data)
         {
             index = original_index;
             auto error = String::allocate();
             error.push("Failed to parse expression associated with definition ");
-            error.push(name);
+            push_name(&error, name);
             return Result<Statement, String>::fail(error);
         }
 
-        skip_whitespace();
-
         if (!expect_token_type(LcTokenTypeSemicolon))
         {
             maybe_expression.value.deallocate();
-            index = original_index;
             auto error = String::allocate();
             error.push("Expected a semicolon at the end of a statement, encountered ");
-            error.push(to_string(current().type));
+            error.push(describe_current());
+            index = original_index;
             return Result<Statement, String>::fail(error);
         }
 
         Statement result;
-        result.name = name.copy();
+        result.name = name;
         result.expression = maybe_expression.value;
         return Result<Statement, String>::success(result);
     }
 };
 
-Option<Expression> parse_terminal_expression(List<Token> tokens)
+Option<Expression> parse_terminal_expression(String source, List<Token> tokens)
 {
-    auto parser = ExpressionParser::allocate(tokens);
+    auto parser = ExpressionParser::allocate(source, tokens);
     auto result = parser.parse_expression();
     if (result.has_data)
     {
-        parser.skip_whitespace();
         if (parser.is_done())
         {
             parser.deallocate();
@@ -855,11 +1045,10 @@ struct ParseStatementsResult
     }
 };
 
-ParseStatementsResult parse_statements(List<Token> tokens)
+ParseStatementsResult parse_statements(String source, List<Token> tokens)
 {
-    auto parser = ExpressionParser::allocate(tokens);
+    auto parser = ExpressionParser::allocate(source, tokens);
     auto statements = List<Statement>::allocate();
-    parser.skip_whitespace();
     bool fail = false;
     String error;
     while (!parser.is_done())
@@ -872,8 +1061,6 @@ ParseStatementsResult parse_statements(List<Token> tokens)
             break;
         }
         statements.push(statement_result.value);
-
-        parser.skip_whitespace();
     }
     parser.deallocate();
     if (fail)
@@ -0,0 +1,153 @@
+// a profile records how much work the reducer has done on each of the definitions of a program; when asked for, it's
+// saved next to the source file after a run, and the run after that uses it to pick the definitions that are worth
+// spending more time optimizing, see run_inlining_pass and run_pre_reduction_pass
+//
+// the file is plain text with a line per definition: its name, how many times it was unfolded and how many nodes were
+// allocated while reducing it (not counting the definitions it unfolded in turn)
+
+// definitions that reach either of these are hot
+const u64 HOT_UNFOLDS_COUNT = 64;
+const u64 HOT_ALLOCATED_NODES = 4096;
+
+struct ProfileEntry
+{
+    Symbol name;
+    u64 unfolds_count;
+    u64 allocated_nodes;
+};
+
+struct Profile
+{
+    List<ProfileEntry> entries;
+    SymbolIndex index; // maps names to their entries
+
+    static Profile allocate()
+    {
+        Profile result;
+        result.entries = List<ProfileEntry>::allocate();
+        result.index = SymbolIndex::allocate();
+        return result;
+    }
+
+    void deallocate()
+    {
+        entries.deallocate();
+        index.deallocate();
+    }
+
+    // returns nullptr if the definition isn't in the profile
+    ProfileEntry* find(Symbol name)
+    {
+        auto maybe_entry_index = index.get(name);
+        if (!maybe_entry_index.has_data) { return nullptr; }
+        return &entries.data[maybe_entry_index.value];
+    }
+
+    void set(Symbol name, u64 unfolds_count, u64 allocated_nodes)
+    {
+        auto entry = find(name);
+        if (entry != nullptr)
+        {
+            entry->unfolds_count = unfolds_count;
+            entry->allocated_nodes = allocated_nodes;
+            return;
+        }
+        ProfileEntry new_entry;
+        new_entry.name = name;
+        new_entry.unfolds_count = unfolds_count;
+        new_entry.allocated_nodes = allocated_nodes;
+        index.set(name, entries.size);
+        entries.push(new_entry);
+    }
+
+    void add(Symbol name, u64 unfolds_count, u64 allocated_nodes)
+    {
+        auto entry = find(name);
+        if (entry == nullptr) { set(name, unfolds_count, allocated_nodes); }
+        else
+        {
+            entry->unfolds_count += unfolds_count;
+            entry->allocated_nodes += allocated_nodes;
+        }
+    }
+
+    // takes the counts from a run over the definitions; generated definitions (like specializations) count towards the
+    // definitions they were generated from, since their own names don't mean anything outside of the run; definitions
+    // that weren't unfolded at all keep their previous counts, since that's usually because of an optimization that
+    // the previous counts led to, and forgetting them would undo that optimization on the run after
+    void update(DefinitionTable definitions)
+    {
+        auto run_profile = Profile::allocate();
+        for (u64 i = 0; i < definitions.entries.size; i++)
+        {
+            auto definition = definitions.entries.data[i];
+            run_profile.add(get_base_symbol(definition.name), definition.unfolds_count, definition.allocated_nodes);
+        }
+        for (u64 i = 0; i < run_profile.entries.size; i++)
+        {
+            auto entry = run_profile.entries.data[i];
+            if (entry.unfolds_count == 0 && find(entry.name) != nullptr) { continue; }
+            set(entry.name, entry.unfolds_count, entry.allocated_nodes);
+        }
+        run_profile.deallocate();
+    }
+
+    bool is_hot(Symbol name)
+    {
+        auto entry = find(get_base_symbol(name));
+        if (entry == nullptr) { return false; }
+        return entry->unfolds_count >= HOT_UNFOLDS_COUNT || entry->allocated_nodes >= HOT_ALLOCATED_NODES;
+    }
+
+    String serialize()
+    {
+        auto result = String::allocate();
+        for (u64 i = 0; i < entries.size; i++)
+        {
+            result.push(symbol_table.get_name(entries.data[i].name));
+            result.push(' ');
+            result.push(entries.data[i].unfolds_count);
+            result.push(' ');
+            result.push(entries.data[i].allocated_nodes);
+            result.push('\n');
+        }
+        return result;
+    }
+
+    // returns nothing if the source isn't a valid profile
+    static Option<Profile> parse(String source)
+    {
+        auto result = Profile::allocate();
+        u64 index = 0;
+        while (index != source.size)
+        {
+            auto name_start = index;
+            while (index != source.size && source.data[index] != ' ' && source.data[index] != '\n') { index++; }
+            auto name = StringView::construct(index - name_start, source.data + name_start);
+            u64 counts[2];
+            auto is_valid = name.size != 0;
+            for (u64 i = 0; i < 2 && is_valid; i++)
+            {
+                is_valid = index != source.size && source.data[index] == ' ';
+                if (!is_valid) { break; }
+                index++;
+                auto digits_start = index;
+                counts[i] = 0;
+                while (index != source.size && source.data[index] >= '0' && source.data[index] <= '9')
+                {
+                    counts[i] = counts[i] * 10 + (source.data[index] - '0');
+                    index++;
+                }
+                is_valid = index != digits_start;
+            }
+            if (!is_valid || index == source.size || source.data[index] != '\n')
+            {
+                result.deallocate();
+                return Option<Profile>::empty();
+            }
+            index++;
+            result.set(symbol_table.intern(name), counts[0], counts[1]);
+        }
+        return Option<Profile>::construct(result);
+    }
+};
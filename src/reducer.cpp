@@ -1,21 +1,101 @@
-Expression beta_reduce(u32 bound_index, Expression argument, Expression body)
+// returns a new reference to the expression with indices of the variables bound outside of it (the ones that are at least
+// `cutoff`) increased by `amount`, which is what needs to happen to an argument when it gets substituted under binders;
+// subexpressions that don't change are shared instead of being rebuilt
+Expression* shift_free_indices(u32 amount, u32 cutoff, Expression* expression)
 {
-    switch (body.type)
+    if (amount == 0) { return dup(expression); }
+    switch (expression->type)
     {
         case ExpressionTypeVariable:
-            if (!body.is_bound || body.bound_index < bound_index) { return copy(body); }
-            if (body.bound_index == bound_index) { return copy(argument); }
-            // else if (body.bound_index > bound_index)
-            body.bound_index--;
-            return copy(body);
+        {
+            if (!expression->is_bound || expression->bound_index < cutoff) { return dup(expression); }
+            auto result = copy(*expression);
+            result.bound_index += amount;
+            return to_node(result);
+        }
+        case ExpressionTypeFunction:
+        {
+            auto body = shift_free_indices(amount, cutoff + 1, expression->body);
+            if (body == expression->body) { drop(body); return dup(expression); }
+            auto result = copy(*expression);
+            drop(result.body);
+            result.body = body;
+            return to_node(result);
+        }
+        case ExpressionTypeApplication:
+        {
+            auto left = shift_free_indices(amount, cutoff, expression->left);
+            auto right = shift_free_indices(amount, cutoff, expression->right);
+            if (left == expression->left && right == expression->right)
+            {
+                drop(left);
+                drop(right);
+                return dup(expression);
+            }
+            auto result = copy(*expression);
+            drop(result.left);
+            drop(result.right);
+            result.left = left;
+            result.right = right;
+            return to_node(result);
+        }
+        default: assert(false); return {};
+    }
+}
+
+// same as shift_free_indices, but takes ownership of the expression and modifies it in place wherever it isn't shared
+Expression* shift_free_indices_in_place(u32 amount, u32 cutoff, Expression* expression)
+{
+    if (amount == 0) { return expression; }
+    switch (expression->type)
+    {
+        case ExpressionTypeVariable:
+            if (!expression->is_bound || expression->bound_index < cutoff) { return expression; }
+            expression = make_unique(expression);
+            expression->bound_index += amount;
+            return rehash(expression);
         case ExpressionTypeFunction:
-            body.parameter_name = body.parameter_name.copy();
-            body.body = copy_to_heap(beta_reduce(bound_index + 1, argument, *body.body));
-            return body;
+            expression = make_unique(expression);
+            expression->body = shift_free_indices_in_place(amount, cutoff + 1, expression->body);
+            return rehash(expression);
         case ExpressionTypeApplication:
-            body.left = copy_to_heap(beta_reduce(bound_index, argument, *body.left));
-            body.right = copy_to_heap(beta_reduce(bound_index, argument, *body.right));
-            return body;
+            expression = make_unique(expression);
+            expression->left = shift_free_indices_in_place(amount, cutoff, expression->left);
+            expression->right = shift_free_indices_in_place(amount, cutoff, expression->right);
+            return rehash(expression);
+        default: assert(false); return {};
+    }
+}
+
+// takes ownership of the body and borrows the argument; nodes of the body that aren't shared are rewritten in place;
+// when the parameter is known to be used only once, move_argument can be set to pass the ownership of the argument as
+// well, it will then be moved to the place of the usage instead of being copied
+Expression* beta_reduce(u32 bound_index, Expression* argument, Expression* body, bool move_argument = false)
+{
+    switch (body->type)
+    {
+        case ExpressionTypeVariable:
+            if (!body->is_bound || body->bound_index < bound_index) { return body; }
+            if (body->bound_index == bound_index)
+            {
+                drop(body);
+                return move_argument
+                    ? shift_free_indices_in_place(bound_index, 0, argument)
+                    : shift_free_indices(bound_index, 0, argument);
+            }
+            // else if (body->bound_index > bound_index)
+            body = make_unique(body);
+            body->bound_index--;
+            return rehash(body);
+        case ExpressionTypeFunction:
+            body = make_unique(body);
+            body->body = beta_reduce(bound_index + 1, argument, body->body, move_argument);
+            return rehash(body);
+        case ExpressionTypeApplication:
+            body = make_unique(body);
+            body->left = beta_reduce(bound_index, argument, body->left, move_argument);
+            body->right = beta_reduce(bound_index, argument, body->right, move_argument);
+            return rehash(body);
         default: assert(false); return {};
     }
 }
@@ -35,99 +115,477 @@ bool has_usages(u32 bound_index, Expression expression)
     }
 }
 
-Expression fix_bound_indices_after_eta_reduction(u32 bound_index, Expression source)
+// counts usages of the variable, but stops as soon as there are more than `limit` of them
+u32 count_usages(u32 bound_index, Expression expression, u32 limit)
 {
-    switch (source.type)
+    switch (expression.type)
     {
         case ExpressionTypeVariable:
-            if (source.bound_index > bound_index) { source.bound_index--; }
-            return copy(source);
+            return expression.is_bound && expression.bound_index == bound_index ? 1 : 0;
         case ExpressionTypeFunction:
-            source.parameter_name = source.parameter_name.copy();
-            source.body = copy_to_heap(fix_bound_indices_after_eta_reduction(bound_index + 1, *source.body));
-            return source;
+            return count_usages(bound_index + 1, *expression.body, limit);
         case ExpressionTypeApplication:
-            source.left = copy_to_heap(fix_bound_indices_after_eta_reduction(bound_index, *source.left));
-            source.right = copy_to_heap(fix_bound_indices_after_eta_reduction(bound_index, *source.right));
+        {
+            auto left_usages = count_usages(bound_index, *expression.left, limit);
+            if (left_usages > limit) { return left_usages; }
+            return left_usages + count_usages(bound_index, *expression.right, limit - left_usages);
+        }
+        default: assert(false); return {};
+    }
+}
+
+// substituting into a body or shifting its free variables never changes the usage count of the parameter, so the
+// result can stay cached on the node for as long as the body isn't reduced
+ParameterUsage get_parameter_usage(Expression* function)
+{
+    assert(function->type == ExpressionTypeFunction);
+    if (function->parameter_usage == ParameterUsageUnknown)
+    {
+        switch (count_usages(0, *function->body, 1))
+        {
+            case 0: function->parameter_usage = ParameterUsageNone; break;
+            case 1: function->parameter_usage = ParameterUsageOnce; break;
+            default: function->parameter_usage = ParameterUsageMany; break;
+        }
+    }
+    return function->parameter_usage;
+}
+
+// takes ownership of the source
+Expression* fix_bound_indices_after_eta_reduction(u32 bound_index, Expression* source)
+{
+    switch (source->type)
+    {
+        case ExpressionTypeVariable:
+            if (source->is_bound && source->bound_index > bound_index)
+            {
+                source = make_unique(source);
+                source->bound_index--;
+                rehash(source);
+            }
             return source;
+        case ExpressionTypeFunction:
+            source = make_unique(source);
+            source->body = fix_bound_indices_after_eta_reduction(bound_index + 1, source->body);
+            return rehash(source);
+        case ExpressionTypeApplication:
+            source = make_unique(source);
+            source->left = fix_bound_indices_after_eta_reduction(bound_index, source->left);
+            source->right = fix_bound_indices_after_eta_reduction(bound_index, source->right);
+            return rehash(source);
         default: assert(false); return {};
     }
 }
 
-Expression eta_reduce(Expression function)
+// takes ownership of the function
+Expression* eta_reduce(Expression* function)
 {
-    assert(function.type == ExpressionTypeFunction);
+    assert(function->type == ExpressionTypeFunction);
 
-    if (function.body->type == ExpressionTypeApplication
-        && function.body->right->type == ExpressionTypeVariable
-        && function.body->right->bound_index == 0
-        && !has_usages(0, *function.body->left))
+    auto body = function->body;
+    if (body->type == ExpressionTypeApplication
+        && body->right->type == ExpressionTypeVariable
+        && body->right->is_bound
+        && body->right->bound_index == 0
+        && !has_usages(0, *body->left))
     {
-        return fix_bound_indices_after_eta_reduction(0, *function.body->left);
+        auto left = dup(body->left);
+        drop(function);
+        return fix_bound_indices_after_eta_reduction(0, left);
     }
-    return copy(function);
+    return function;
+}
+
+const u64 RECURSION_LIMIT = 300;
+
+Result<Expression*, String> make_recursion_limit_error()
+{
+    auto error = String::allocate();
+    error.push("Recursion limit of ");
+    error.push(RECURSION_LIMIT);
+    error.push(" reached");
+    return Result<Expression*, String>::fail(error);
+}
+
+// half of the smallest default stack there is (Windows' is 1 MB), the rest is left for the functions that the reducer
+// calls, which recurse on their own
+const u64 MAX_REDUCTION_STACK_SIZE = 512 * 1024;
+
+Result<Expression*, String> make_stack_limit_error()
+{
+    auto error = String::allocate();
+    error.push("Stack limit of ");
+    error.push(MAX_REDUCTION_STACK_SIZE);
+    error.push(" bytes reached");
+    return Result<Expression*, String>::fail(error);
+}
+
+// reductions that are only worth doing when they're cheap (see Specializer) get a number of steps to finish in, a step
+// being every check of the depth, so every application walked into, beta reduction, and body or argument reduced
+const u64 NO_STEP_LIMIT = (u64)-1;
+
+Result<Expression*, String> make_step_limit_error()
+{
+    return Result<Expression*, String>::fail(String::copy_from_c_string("Step limit reached"));
 }
 
-Result<Expression, String> reduce(Expression expression, u64 recursion_counter = 0)
+// reduces expressions in normal order, global variables are unfolded into their definitions only once they end up in
+// head position, so arguments that get thrown away never have their globals looked at;
+// all methods take ownership of the expression they're given and rewrite it in place wherever its nodes aren't shared,
+// on failure the expression is freed
+struct Reducer
 {
-    u64 recursion_limit = 300;
-    if (recursion_counter == recursion_limit)
+    DefinitionTable definitions;
+    // the recursion limit is only there to catch reductions that never end, so it can be turned off for expressions
+    // that are known to terminate, see TypeInference; those still nest on the call stack though, so they're stopped
+    // once they take up MAX_REDUCTION_STACK_SIZE of it instead of overflowing it
+    bool is_guarded;
+    u64 stack_start; // address of a local of the function that constructed the reducer
+    u64 steps_left; // NO_STEP_LIMIT unless the reduction has a budget
+    // the definition whose unfolding is being reduced right now, which new nodes get charged to, see charge_allocations
+    Definition* current_definition;
+    u64 charged_allocations_count;
+
+    static Reducer construct(DefinitionTable definitions, bool is_guarded = true)
     {
-        auto error = String::allocate();
-        error.push("Recursion limit of ");
-        error.push(recursion_limit);
-        error.push(" reached");
-        return Result<Expression, String>::fail(error);
+        Reducer result;
+        result.definitions = definitions;
+        result.is_guarded = is_guarded;
+        byte stack_marker;
+        result.stack_start = (u64)&stack_marker;
+        result.steps_left = NO_STEP_LIMIT;
+        result.current_definition = nullptr;
+        result.charged_allocations_count = term_heap.allocations_count;
+        return result;
     }
-    recursion_counter++;
 
-    Expression result;
-    switch (expression.type)
+    // charges the nodes allocated since the last call to the current definition
+    void charge_allocations()
     {
-        case ExpressionTypeVariable:
+        if (current_definition != nullptr)
         {
-            result = copy(expression);
-            break;
+            current_definition->allocated_nodes += term_heap.allocations_count - charged_allocations_count;
         }
-        case ExpressionTypeFunction:
+        charged_allocations_count = term_heap.allocations_count;
+    }
+
+    // returns a failure once the reduction is nested too deep to go on, or has run out of steps
+    Result<Expression*, String> check_depth(u64 recursion_counter)
+    {
+        if (steps_left != NO_STEP_LIMIT)
         {
-            auto reducing_body_result = reduce(*expression.body, recursion_counter);
-            if (!reducing_body_result.is_success) { return reducing_body_result; }
-            auto reduced_body = copy_to_heap(reducing_body_result.value);
-            expression.body = reduced_body;
-            auto eta_reduced_expression = eta_reduce(expression);
-            reduced_body->deallocate();
-            default_deallocate(reduced_body);
-            result = eta_reduced_expression;
-            break;
+            if (steps_left == 0) { return make_step_limit_error(); }
+            steps_left--;
         }
-        case ExpressionTypeApplication:
+        if (is_guarded)
+        {
+            if (recursion_counter == RECURSION_LIMIT) { return make_recursion_limit_error(); }
+            return Result<Expression*, String>::success(nullptr);
+        }
+        byte stack_marker;
+        auto stack_position = (u64)&stack_marker;
+        // the stack grows downwards on every platform this runs on
+        if (stack_position < stack_start && stack_start - stack_position > MAX_REDUCTION_STACK_SIZE)
+        {
+            return make_stack_limit_error();
+        }
+        return Result<Expression*, String>::success(nullptr);
+    }
+
+    Definition* find_definition(Expression* variable)
+    {
+        if (variable->is_bound) { return nullptr; }
+        // variables that come from the definitions are already linked, others (like the ones in an expression parsed
+        // separately from the program, or copied out of a table that's gone by now) have to be looked up by name
+        if (definitions.owns(variable->definition)) { return variable->definition; }
+        return definitions.get(variable->global_name);
+    }
+
+    // the first time a definition gets unfolded its normal form is computed and cached, so that definitions like
+    // `two = succ one` are only reduced once no matter how many times they are used; recursive definitions (see
+    // mark_recursive_definitions, or the ones that turn out to be unfolded while their normal form is being computed)
+    // rarely have one, so they aren't even tried, and along with the ones whose normal form can't be computed they are
+    // unfolded as is;
+    // the computation goes on from the recursion counter of the unfolding, since definitions that are unfolded while
+    // computing a normal form get their normal forms computed as well, and chains of those nest as deep as the chains
+    // of definitions go; running out of depth part of the way down doesn't mean that there's no normal form though, so
+    // that's only taken for an answer when the computation had all of the depth to itself, otherwise the definition
+    // is unfolded as is and the computation is tried again once it's unfolded from further up
+    Expression* unfold(Definition* definition, u64 recursion_counter = 0)
+    {
+        if (definition->normal_form_state == NormalFormStateUnknown && definition->is_recursive)
+        {
+            definition->normal_form_state = NormalFormStateMissing;
+        }
+        if (
+            definition->normal_form_state == NormalFormStateUnknown
+                && recursion_counter < definition->normal_form_failed_at
+        )
         {
-            auto reducing_left_result = reduce(*expression.left, recursion_counter);
-            if (!reducing_left_result.is_success) { return reducing_left_result; }
-            auto reducing_right_result = reduce(*expression.right, recursion_counter);
-            if (!reducing_right_result.is_success)
+            definition->normal_form_state = NormalFormStateComputing;
+            auto reducing_result = reduce_in_place(dup(definition->node), recursion_counter);
+            if (reducing_result.is_success)
             {
-                reducing_left_result.value.deallocate();
-                return reducing_right_result;
+                definition->normal_form = reducing_result.value;
+                definition->normal_form_state = NormalFormStateKnown;
+                mark_strict_parameters(
+                    definition->normal_form,
+                    get_strict_parameters(definitions, *definition->normal_form)
+                );
             }
-            auto reduced_left = reducing_left_result.value;
-            auto reduced_right = reducing_right_result.value;
-            if (reduced_left.type == ExpressionTypeFunction)
+            else
             {
-                auto beta_reduced = beta_reduce(0, reduced_right, *reduced_left.body);
-                reduced_left.deallocate();
-                reduced_right.deallocate();
-                auto reducing_application_result = reduce(beta_reduced, recursion_counter);
-                beta_reduced.deallocate();
-                return reducing_application_result;
+                reducing_result.error.deallocate();
+                definition->normal_form_failed_at = recursion_counter;
+                if (recursion_counter == 0) { definition->normal_form_state = NormalFormStateMissing; }
+                else { definition->normal_form_state = NormalFormStateUnknown; }
             }
-            expression.left = copy_to_heap(reduced_left);
-            expression.right = copy_to_heap(reduced_right);
-            result = expression;
-            break;
         }
-        default: assert(false); return {};
+        if (definition->normal_form_state == NormalFormStateKnown) { return dup(definition->normal_form); }
+        return dup(definition->node);
+    }
+
+    // takes ownership of both the function and the argument, frees both on failure
+    Result<Expression*, String> apply(Expression* function, Expression* argument, u64 recursion_counter)
+    {
+        auto usage = get_parameter_usage(function);
+        auto is_parameter_strict = function->is_parameter_strict;
+        auto function_value = take(function);
+        switch (usage)
+        {
+            case ParameterUsageNone:
+                // the argument is thrown away, so there's no need to even look at it; as with eta reduction, the binder
+                // is gone but its variable isn't used anywhere
+                drop(argument);
+                return Result<Expression*, String>::success(
+                    fix_bound_indices_after_eta_reduction(0, function_value.body)
+                );
+            case ParameterUsageOnce: // the only usage can take the argument over
+                return Result<Expression*, String>::success(beta_reduce(0, argument, function_value.body, true));
+            default:
+            {
+                // the argument is going to be normalized anyway, so it's better to do it once before it's copied than
+                // for each of the copies after
+                if (is_parameter_strict)
+                {
+                    auto reducing_argument_result = reduce_in_place(argument, recursion_counter);
+                    if (!reducing_argument_result.is_success)
+                    {
+                        drop(function_value.body);
+                        return reducing_argument_result;
+                    }
+                    argument = reducing_argument_result.value;
+                }
+                auto result = beta_reduce(0, argument, function_value.body);
+                drop(argument);
+                return Result<Expression*, String>::success(result);
+            }
+        }
+    }
+
+    // reduces the expression only until its head is known, meaning that it stops at functions without looking into their
+    // bodies and at applications whose head is a variable that can't be unfolded;
+    // the applications along the left side are walked down in a loop instead of recursively, each of them pointing
+    // back to the one it's the left side of until the head is known (they're made unique first, so nothing else can
+    // see that), and the head gets unfolded or applied to the innermost argument in the same loop, so neither long
+    // spines nor long chains of definitions that unfold into each other nest; the recursion counter still goes up for
+    // every application walked into and every beta reduction, just like it did when those were recursive calls, and
+    // an application keeps the counter it was walked into with in its hash, which gets computed anew once the
+    // application is put back together;
+    // unfolding a definition doesn't count, and neither does applying its parameters to their arguments, the way each
+    // round of resolving names used to start the count over; so that unfolding the same definitions over and over
+    // still runs into the limit, parameters are only applied for free as many times in a row as there are definitions,
+    // and never the ones of recursive definitions
+    Result<Expression*, String> reduce_head(Expression* expression, u64 recursion_counter)
+    {
+        auto checking_depth_result = check_depth(recursion_counter);
+        if (!checking_depth_result.is_success)
+        {
+            drop(expression);
+            return checking_depth_result;
+        }
+        recursion_counter++;
+
+        Expression* parent = nullptr; // the innermost application walked into so far, see above
+        u64 free_applications_count = 0; // parameters of the last unfolded definition that are left to be applied
+        auto free_unfoldings_count = definitions.entries.size;
+        auto unfolding_definition = current_definition;
+        auto result = Result<Expression*, String>::success(nullptr);
+        while (true)
+        {
+            if (expression->type == ExpressionTypeApplication)
+            {
+                result = check_depth(recursion_counter);
+                if (!result.is_success)
+                {
+                    drop(expression);
+                    break;
+                }
+                expression = make_unique(expression);
+                expression->hash = recursion_counter;
+                recursion_counter++;
+                free_applications_count = 0;
+                auto left = expression->left;
+                expression->left = parent;
+                parent = expression;
+                expression = left;
+                continue;
+            }
+            if (expression->type == ExpressionTypeVariable)
+            {
+                auto definition = find_definition(expression);
+                if (definition == nullptr) { break; }
+                drop(expression);
+                // definitions that get unfolded while reducing this one are charged for their own allocations
+                definition->unfolds_count++;
+                charge_allocations();
+                current_definition = definition;
+                expression = unfold(definition, recursion_counter);
+                free_applications_count = 0;
+                if (!definition->is_recursive && free_unfoldings_count != 0)
+                {
+                    free_unfoldings_count--;
+                    auto function = expression;
+                    while (function->type == ExpressionTypeFunction)
+                    {
+                        free_applications_count++;
+                        function = function->body;
+                    }
+                }
+                continue;
+            }
+            assert(expression->type == ExpressionTypeFunction);
+            if (parent == nullptr) { break; }
+            auto application = parent;
+            parent = application->left;
+            recursion_counter = application->hash;
+            auto argument = application->right;
+            free_node(application);
+            result = apply(expression, argument, recursion_counter);
+            if (!result.is_success) { break; }
+            expression = result.value;
+            if (free_applications_count != 0)
+            {
+                free_applications_count--;
+                continue;
+            }
+            result = check_depth(recursion_counter);
+            if (!result.is_success)
+            {
+                drop(expression);
+                break;
+            }
+            recursion_counter++;
+        }
+        charge_allocations();
+        current_definition = unfolding_definition;
+
+        while (parent != nullptr)
+        { // the head is stuck, so the applications get put back together around it, or freed on failure
+            auto application = parent;
+            parent = application->left;
+            if (result.is_success)
+            {
+                application->left = expression;
+                expression = rehash(application);
+            }
+            else
+            {
+                drop(application->right);
+                free_node(application);
+            }
+        }
+        if (!result.is_success) { return result; }
+        return Result<Expression*, String>::success(expression);
+    }
+
+    Result<Expression*, String> reduce_in_place(Expression* expression, u64 recursion_counter = 0)
+    {
+        auto reducing_head_result = reduce_head(expression, recursion_counter);
+        if (!reducing_head_result.is_success) { return reducing_head_result; }
+        expression = reducing_head_result.value;
+
+        auto checking_depth_result = check_depth(recursion_counter);
+        if (!checking_depth_result.is_success)
+        {
+            drop(expression);
+            return checking_depth_result;
+        }
+        recursion_counter++;
+
+        switch (expression->type)
+        {
+            case ExpressionTypeVariable: break;
+            case ExpressionTypeFunction:
+            {
+                expression = make_unique(expression);
+                auto reducing_body_result = reduce_in_place(expression->body, recursion_counter);
+                if (!reducing_body_result.is_success)
+                {
+                    free_node(expression);
+                    return reducing_body_result;
+                }
+                expression->body = reducing_body_result.value;
+                expression->parameter_usage = ParameterUsageUnknown;
+                expression = eta_reduce(rehash(expression));
+                break;
+            }
+            case ExpressionTypeApplication:
+            { // the head is stuck, so all that's left is to reduce the arguments
+                // the applications along the left side are walked down the same way reduce_head does it, so that long
+                // spines don't nest on the call stack either
+                Expression* parent = nullptr;
+                while (expression->type == ExpressionTypeApplication)
+                {
+                    expression = make_unique(expression);
+                    auto left = expression->left;
+                    expression->left = parent;
+                    parent = expression;
+                    expression = left;
+                }
+                // a function would have been applied, so the head is a variable that can't be unfolded
+                assert(expression->type == ExpressionTypeVariable);
+                auto result = Result<Expression*, String>::success(nullptr);
+                while (parent != nullptr)
+                { // the arguments get reduced innermost first, or freed once one of them fails
+                    auto application = parent;
+                    parent = application->left;
+                    if (!result.is_success)
+                    {
+                        drop(application->right);
+                        free_node(application);
+                        continue;
+                    }
+                    result = reduce_in_place(application->right, recursion_counter);
+                    if (!result.is_success)
+                    {
+                        drop(expression);
+                        free_node(application);
+                        continue;
+                    }
+                    application->left = expression;
+                    application->right = result.value;
+                    expression = rehash(application);
+                }
+                if (!result.is_success) { return result; }
+                break;
+            }
+            default: assert(false); return {};
+        }
+        return Result<Expression*, String>::success(expression);
     }
-    return Result<Expression, String>::success(result);
+};
+
+// reduces an expression that doesn't refer to any definitions
+Result<Expression*, String> reduce_in_place(Expression* expression)
+{
+    DefinitionTable no_definitions = {};
+    return Reducer::construct(no_definitions).reduce_in_place(expression);
+}
+
+Result<Expression, String> reduce(Expression expression)
+{
+    auto reducing_result = reduce_in_place(to_node(copy(expression)));
+    if (!reducing_result.is_success) { return Result<Expression, String>::fail(reducing_result.error); }
+    return Result<Expression, String>::success(take(reducing_result.value));
 }
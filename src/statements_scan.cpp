@@ -0,0 +1,86 @@
+// a quick pass over the source that finds where statements are and what they're named without tokenizing or parsing
+// them, for the parsers that don't go through statements one by one from the start, see parse_statements_in_parallel
+// and parse_reachable_statements; semicolons only ever end statements, so a statement is everything up to the next one
+//
+// all that parsing a statement needs to know about the ones before it are their names, so with the scan done any
+// statement can be parsed on its own; the scan finds duplicates while it's at it
+
+String make_tokenization_error(u64 failed_at_index)
+{
+    auto error = String::allocate();
+    error.push("Tokenization failed at character ");
+    error.push(failed_at_index);
+    return error;
+}
+
+struct StatementRange
+{
+    u64 offset;
+    u64 size; // the semicolon included, if there is one
+    Symbol name; // NO_SYMBOL if the statement doesn't start with a name, in which case it fails to parse anyway
+};
+
+struct StatementsScan
+{
+    List<StatementRange> statements;
+    SymbolIndex names; // maps names to the index of the first statement with that name
+    bool has_duplicate;
+    u64 duplicate_statement_index; // the first statement that has the same name as one before it
+    Symbol duplicate_name;
+
+    // the source has to fit into MAX_SOURCE_SIZE
+    static StatementsScan scan(String source)
+    {
+        assert(source.size <= MAX_SOURCE_SIZE, "StatementsScan::scan: source is too large");
+        StatementsScan result;
+        result.statements = List<StatementRange>::allocate();
+        result.names = SymbolIndex::allocate();
+        result.has_duplicate = false;
+        result.duplicate_statement_index = 0;
+        result.duplicate_name = NO_SYMBOL;
+        auto scanner = Tokenizer::construct(source, true);
+        while (true)
+        {
+            scanner.skip_whitespace();
+            if (scanner.is_done()) { break; }
+            StatementRange statement;
+            statement.offset = scanner.index;
+            statement.name = NO_SYMBOL;
+            // whatever comes after the name doesn't have to be a valid token, the parser finds that out
+            if (is_name_start(scanner.current()))
+            {
+                scanner.index++;
+                scanner.skip_name_tail();
+                auto name_size = scanner.index - statement.offset;
+                statement.name = symbol_table.intern(StringView::construct(name_size, source.data + statement.offset));
+                if (!result.names.has(statement.name)) { result.names.set(statement.name, result.statements.size); }
+                else if (!result.has_duplicate)
+                {
+                    result.has_duplicate = true;
+                    result.duplicate_statement_index = result.statements.size;
+                    result.duplicate_name = statement.name;
+                }
+            }
+            scanner.skip_to_semicolon();
+            if (!scanner.is_done()) { scanner.index++; }
+            statement.size = scanner.index - statement.offset;
+            result.statements.push(statement);
+        }
+        return result;
+    }
+
+    void deallocate()
+    {
+        statements.deallocate();
+        names.deallocate();
+    }
+
+    // parsing gets to a duplicate before it parses the statement
+    String make_duplicate_error()
+    {
+        auto error = String::allocate();
+        error.push("Parsing failed: Encountered duplicate definition: ");
+        error.push(symbol_table.get_name(duplicate_name));
+        return error;
+    }
+};
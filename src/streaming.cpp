@@ -0,0 +1,173 @@
+// reads statements from a file a chunk at a time and tokenizes and parses each one as soon as its semicolon comes in,
+// instead of reading, tokenizing and parsing the whole file in three separate steps; the source and the tokens never
+// take more memory than the largest statement does, which lets programs come from pipes (or the standard input) and be
+// larger than what would fit into memory three times over
+//
+// this relies on a semicolon only ever ending a statement, so a statement is everything up to the next one
+
+const u64 STREAM_CHUNK_SIZE = 64 * 1024;
+
+struct StatementStream
+{
+    InputFile file;
+    bool is_file_done;
+    String buffer; // what's been read from the file, the part that hasn't been parsed yet starts at start
+    u64 start;
+    u64 scanned_size; // there are no semicolons between start and this
+    u64 consumed_size; // how much of the file came before start, for reporting positions of errors
+    ExpressionParser parser; // kept from one statement to the next, since it remembers names to check for duplicates
+
+    static StatementStream allocate(InputFile file)
+    {
+        StatementStream result;
+        result.file = file;
+        result.is_file_done = false;
+        result.buffer = String::allocate(STREAM_CHUNK_SIZE);
+        result.start = 0;
+        result.scanned_size = 0;
+        result.consumed_size = 0;
+        result.parser = ExpressionParser::allocate(result.buffer, List<Token>::allocate());
+        return result;
+    }
+
+    void deallocate()
+    {
+        buffer.deallocate();
+        parser.tokens.deallocate();
+        parser.deallocate();
+    }
+
+    // reads until there's either something other than whitespace in the buffer or nothing left in the file
+    Result<bool, String> is_done()
+    {
+        while (true)
+        {
+            auto whitespace_end = start;
+            while (whitespace_end != buffer.size && is_whitespace(buffer.data[whitespace_end])) { whitespace_end++; }
+            consume(whitespace_end - start);
+            if (start != buffer.size) { return Result<bool, String>::success(false); }
+            if (is_file_done) { return Result<bool, String>::success(true); }
+            if (!read_chunk()) { return Result<bool, String>::fail(make_read_error()); }
+        }
+    }
+
+    // errors are the same as the ones main reports when it reads the whole file at once
+    Result<Statement, String> parse_next()
+    {
+        u64 statement_size = 0;
+        while (statement_size == 0)
+        {
+            auto scanner = Tokenizer::construct(buffer, true);
+            scanner.index = scanned_size;
+            scanner.skip_to_semicolon();
+            scanned_size = scanner.index;
+            if (scanned_size != buffer.size) { statement_size = scanned_size + 1 - start; }
+            // whatever is left is an unfinished statement, and parsing it gives the right error
+            else if (is_file_done) { statement_size = buffer.size - start; }
+            else if (!read_chunk()) { return Result<Statement, String>::fail(make_read_error()); }
+        }
+
+        auto statement_source = buffer;
+        statement_source.data += start;
+        statement_source.size = statement_size;
+        statement_source.capacity = statement_size;
+        auto tokenization_result = tokenize(statement_source);
+        if (!tokenization_result.success)
+        {
+            auto error = String::allocate();
+            error.push("Tokenization failed at character ");
+            error.push(consumed_size + tokenization_result.failed_at_index);
+            return Result<Statement, String>::fail(error);
+        }
+        parser.tokens.deallocate();
+        parser.source = statement_source;
+        parser.tokens = tokenization_result.tokens;
+        parser.index = 0;
+        auto statement_result = parser.parse_statement();
+        if (!statement_result.is_success)
+        {
+            auto error = String::allocate();
+            error.push("Parsing failed: ");
+            error.push(statement_result.error);
+            statement_result.error.deallocate();
+            return Result<Statement, String>::fail(error);
+        }
+        consume(statement_size);
+        return statement_result;
+    }
+
+private:
+    // returns false if the file couldn't be read
+    bool read_chunk()
+    {
+        // what's been parsed is only thrown away when there's no room left after it, so each byte gets moved at most
+        // once per chunk that's read, rather than once per statement
+        if (buffer.capacity - buffer.size < STREAM_CHUNK_SIZE && start != 0)
+        {
+            copy_memory(buffer.data + start, buffer.size - start, buffer.data); // goes forwards, so overlap is fine
+            buffer.size -= start;
+            scanned_size -= start;
+            start = 0;
+        }
+        if (buffer.capacity - buffer.size < STREAM_CHUNK_SIZE)
+        { // only statements that are larger than a chunk make the buffer grow
+            buffer.reserve_at_least(max(buffer.capacity * 2, buffer.size + STREAM_CHUNK_SIZE));
+        }
+        auto read_result = file.read_into(buffer.data + buffer.size, STREAM_CHUNK_SIZE);
+        if (read_result < 0) { return false; }
+        if (read_result == 0) { is_file_done = true; }
+        buffer.size += read_result;
+        return true;
+    }
+
+    void consume(u64 size)
+    {
+        start += size;
+        scanned_size = max(scanned_size, start);
+        consumed_size += size;
+    }
+
+    String make_read_error()
+    {
+        auto error = String::allocate();
+        error.push("Failed to read the source after character ");
+        error.push(consumed_size + buffer.size - start);
+        return error;
+    }
+};
+
+// the error is the whole message to report, unlike with parse_statements
+ParseStatementsResult parse_statements_from_file(InputFile file)
+{
+    auto stream = StatementStream::allocate(file);
+    auto statements = List<Statement>::allocate();
+    String error;
+    auto fail = false;
+    while (true)
+    {
+        auto is_done_result = stream.is_done();
+        if (!is_done_result.is_success)
+        {
+            fail = true;
+            error = is_done_result.error;
+            break;
+        }
+        if (is_done_result.value) { break; }
+        auto statement_result = stream.parse_next();
+        if (!statement_result.is_success)
+        {
+            fail = true;
+            error = statement_result.error;
+            break;
+        }
+        statements.push(statement_result.value);
+    }
+    stream.deallocate();
+    if (fail)
+    {
+        for (u64 i = 0; i < statements.size; i++) { statements.data[i].deallocate(); }
+        statements.deallocate();
+        return ParseStatementsResult::make_fail(error);
+    }
+    return ParseStatementsResult::make_success(statements);
+}
@@ -0,0 +1,119 @@
+// strictness analysis: a parameter is strict when the function's body can't have a normal form unless the argument has
+// one, in which case the reducer can reduce the argument before substituting it (see Reducer::apply) instead of
+// reducing each of its copies separately, without the risk of doing work that wouldn't have been done otherwise
+//
+// the analysis is an abstract interpretation that only looks at positions that normalization is guaranteed to reach:
+// bodies of functions, variables that aren't applied to anything, arguments of applications that are stuck on a global
+// that isn't defined, and arguments at strict positions of definitions; anything that depends on what a parameter gets
+// substituted with is assumed to be lazy, and that includes a parameter that is applied to arguments, since only the
+// application gets normalized, not the function on its own (e.g. `\ z . z loop` has no normal form, but `f` in
+// `f (f x)` can still be substituted with it without the application lacking one)
+
+const u64 MAX_STRICT_PARAMETERS = 64; // strictness of each definition is a bit set
+
+// checks whether the variable with the given de Bruijn index is certain to be normalized as part of the expression
+bool is_strict_in(DefinitionTable definitions, u32 bound_index, Expression expression)
+{
+    switch (expression.type)
+    {
+        case ExpressionTypeVariable: return expression.is_bound && expression.bound_index == bound_index;
+        case ExpressionTypeFunction: return is_strict_in(definitions, bound_index + 1, *expression.body);
+        case ExpressionTypeApplication:
+        {
+            auto head = expression;
+            u64 arguments_count = 0;
+            while (head.type == ExpressionTypeApplication)
+            {
+                head = *head.left;
+                arguments_count++;
+            }
+            // the head is going to be substituted, so nothing is known about it or its arguments
+            if (head.type == ExpressionTypeVariable && head.is_bound) { return false; }
+            if (head.type == ExpressionTypeFunction)
+            { // the head is a redex, whatever is strict in its body still is after it gets reduced
+                auto body = head;
+                u64 parameters_count = 0;
+                while (body.type == ExpressionTypeFunction)
+                {
+                    body = *body.body;
+                    parameters_count++;
+                }
+                // unless there are arguments left over, which the reduced body gets applied to, and then it's in the
+                // head position instead, where it can be thrown away (e.g. `(\ a . x) x (\ u v . v)`)
+                if (arguments_count > parameters_count) { return false; }
+                return is_strict_in(definitions, bound_index, head);
+            }
+
+            auto definition = definitions.get(head.global_name);
+            auto argument = expression;
+            for (u64 i = arguments_count; i != 0; i--)
+            { // arguments are visited from the last one
+                auto position = i - 1;
+                auto is_normalized = definition == nullptr
+                    || (position < MAX_STRICT_PARAMETERS && (definition->strict_parameters >> position & 1) != 0);
+                if (is_normalized && is_strict_in(definitions, bound_index, *argument.right)) { return true; }
+                argument = *argument.left;
+            }
+            return false;
+        }
+        default: assert(false); return {};
+    }
+}
+
+// returns the bit set of the strict parameters of the function, which can be any expression with a chain of functions
+// at its head
+u64 get_strict_parameters(DefinitionTable definitions, Expression function)
+{
+    u64 parameters_count = 0;
+    auto body = function;
+    while (body.type == ExpressionTypeFunction)
+    {
+        body = *body.body;
+        parameters_count++;
+    }
+
+    u64 result = 0;
+    for (u64 i = 0; i < parameters_count && i < MAX_STRICT_PARAMETERS; i++)
+    {
+        if (is_strict_in(definitions, parameters_count - i - 1, body)) { result |= (u64)1 << i; }
+    }
+    return result;
+}
+
+void mark_strict_parameters(Expression* function, u64 strict_parameters)
+{
+    for (u64 i = 0; function->type == ExpressionTypeFunction; i++)
+    {
+        function->is_parameter_strict = i < MAX_STRICT_PARAMETERS && (strict_parameters >> i & 1) != 0;
+        function = function->body;
+    }
+}
+
+// computes strictness of all of the definitions and marks their parameters; recursive definitions are handled by
+// starting from every parameter being lazy and strengthening that assumption until nothing changes, which finds the
+// least fixed point; the greatest one would be sound as well (a definition without a normal form is strict in
+// everything), but it makes definitions like `r = \ x . r (x x)` strict, and reducing their arguments ahead of time
+// only builds ever larger terms before running into the recursion limit
+void analyze_strictness(DefinitionTable definitions)
+{
+    for (u64 i = 0; i < definitions.entries.size; i++) { definitions.entries.data[i].strict_parameters = 0; }
+    auto has_changed = true;
+    while (has_changed)
+    {
+        has_changed = false;
+        for (u64 i = 0; i < definitions.entries.size; i++)
+        {
+            auto definition = &definitions.entries.data[i];
+            auto strict_parameters = get_strict_parameters(definitions, *definition->node);
+            if (strict_parameters != definition->strict_parameters)
+            {
+                definition->strict_parameters = strict_parameters;
+                has_changed = true;
+            }
+        }
+    }
+    for (u64 i = 0; i < definitions.entries.size; i++)
+    {
+        mark_strict_parameters(definitions.entries.data[i].node, definitions.entries.data[i].strict_parameters);
+    }
+}
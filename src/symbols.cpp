@@ -0,0 +1,221 @@
+// every identifier in the program is interned into the symbol table when it's tokenized, from then on names are passed
+// around, compared and hashed as 32-bit IDs instead of strings
+typedef u32 Symbol;
+
+u64 hash_string(StringView source)
+{ // FNV-1a
+    u64 result = 14695981039346656037ull;
+    for (u64 i = 0; i < source.size; i++)
+    {
+        result ^= (u8)source.data[i];
+        result *= 1099511628211ull;
+    }
+    return result;
+}
+
+static bool operator==(String left, StringView right)
+{
+    if (left.size != right.size) { return false; }
+    for (u64 i = 0; i < left.size; i++)
+    {
+        if (left.data[i] != right.data[i]) { return false; }
+    }
+    return true;
+}
+
+struct SymbolTable
+{
+    List<String> names; // indexed by symbol
+    // open addressing hash table of symbols, each slot holds symbol + 1 so that 0 can mean an empty slot
+    u32* slots;
+    u64 slots_count; // always a power of two
+
+    static const u64 INITIAL_SLOTS_COUNT = 1024;
+
+    Symbol intern(StringView name)
+    {
+        if (slots == nullptr) { allocate_slots(INITIAL_SLOTS_COUNT); names = List<String>::allocate(); }
+
+        auto slot_index = hash_string(name) & (slots_count - 1);
+        while (slots[slot_index] != 0)
+        {
+            auto symbol = slots[slot_index] - 1;
+            if (names.data[symbol] == name) { return symbol; }
+            slot_index = (slot_index + 1) & (slots_count - 1);
+        }
+
+        Symbol symbol = names.size;
+        auto name_copy = String::allocate(max(name.size, (u64)1));
+        name_copy.push(name);
+        names.push(name_copy);
+        slots[slot_index] = symbol + 1;
+        if (names.size * 2 > slots_count) { grow(); }
+        return symbol;
+    }
+
+    Symbol intern(CStringView name) { return intern(StringView::from_c_string(name)); }
+
+    String get_name(Symbol symbol)
+    {
+        assert(symbol < names.size, "SymbolTable::get_name: unknown symbol");
+        return names.data[symbol];
+    }
+
+    // only for tables other than symbol_table, which lives as long as the program does
+    void deallocate()
+    {
+        if (slots == nullptr) { return; }
+        for (u64 i = 0; i < names.size; i++) { names.data[i].deallocate(); }
+        names.deallocate();
+        default_deallocate(slots);
+        slots = nullptr;
+    }
+
+private:
+    void allocate_slots(u64 count)
+    {
+        slots_count = count;
+        slots = (u32*)default_allocate(sizeof(u32) * slots_count);
+        set_memory(0, sizeof(u32) * slots_count, slots);
+    }
+
+    void grow()
+    {
+        auto old_slots = slots;
+        allocate_slots(slots_count * 2);
+        for (u64 i = 0; i < names.size; i++)
+        {
+            auto slot_index = hash_string(names.data[i].to_string_view()) & (slots_count - 1);
+            while (slots[slot_index] != 0) { slot_index = (slot_index + 1) & (slots_count - 1); }
+            slots[slot_index] = i + 1;
+        }
+        default_deallocate(old_slots);
+    }
+};
+
+SymbolTable symbol_table = {};
+
+// names made up by the interpreter itself (like the ones of definitions created by the optimizer) have a ' in them,
+// which can't be a part of a name in the source, so they never clash with the program's own names
+Symbol generate_symbol(Symbol base, u64 number)
+{
+    auto name = symbol_table.get_name(base).copy();
+    name.push('\'');
+    name.push(number);
+    auto result = symbol_table.intern(name.to_string_view());
+    name.deallocate();
+    return result;
+}
+
+bool is_generated_symbol(Symbol symbol)
+{
+    auto name = symbol_table.get_name(symbol);
+    for (u64 i = 0; i < name.size; i++)
+    {
+        if (name.data[i] == '\'') { return true; }
+    }
+    return false;
+}
+
+// the name a generated symbol was made from, symbols that weren't generated are their own base
+Symbol get_base_symbol(Symbol symbol)
+{
+    auto name = symbol_table.get_name(symbol);
+    for (u64 i = 0; i < name.size; i++)
+    {
+        if (name.data[i] == '\'') { return symbol_table.intern(StringView::construct(i, name.data)); }
+    }
+    return symbol;
+}
+
+u64 hash_symbol(Symbol symbol)
+{ // Fibonacci hashing, good enough since symbols are small consecutive numbers
+    return (u64)symbol * 11400714819323198485ull;
+}
+
+const Symbol NO_SYMBOL = (Symbol)-1;
+
+struct SymbolIndexSlot
+{
+    Symbol symbol; // NO_SYMBOL for empty slots
+    u32 value;
+};
+
+// open addressing hash table that maps symbols to indices
+struct SymbolIndex
+{
+    SymbolIndexSlot* slots;
+    u64 slots_count; // always a power of two, or 0 if nothing has been allocated
+    u64 size;
+
+    static SymbolIndex allocate(u64 expected_size = 16)
+    {
+        SymbolIndex result;
+        result.slots_count = 16;
+        while (result.slots_count < expected_size * 2) { result.slots_count *= 2; }
+        result.size = 0;
+        result.slots = allocate_slots(result.slots_count);
+        return result;
+    }
+
+    void deallocate()
+    {
+        if (slots_count != 0) { default_deallocate(slots); }
+        slots_count = 0;
+    }
+
+    bool has(Symbol symbol) { return get(symbol).has_data; }
+
+    Option<u32> get(Symbol symbol)
+    {
+        if (slots_count == 0) { return Option<u32>::empty(); }
+        auto slot_index = find_slot(slots, slots_count, symbol);
+        if (slots[slot_index].symbol == NO_SYMBOL) { return Option<u32>::empty(); }
+        return Option<u32>::construct(slots[slot_index].value);
+    }
+
+    // overwrites the value if the symbol is already in the index
+    void set(Symbol symbol, u32 value)
+    {
+        auto slot_index = find_slot(slots, slots_count, symbol);
+        if (slots[slot_index].symbol == NO_SYMBOL)
+        {
+            slots[slot_index].symbol = symbol;
+            size++;
+        }
+        slots[slot_index].value = value;
+        if (size * 2 > slots_count) { grow(); }
+    }
+
+private:
+    static SymbolIndexSlot* allocate_slots(u64 count)
+    {
+        auto result = (SymbolIndexSlot*)default_allocate(sizeof(SymbolIndexSlot) * count);
+        for (u64 i = 0; i < count; i++) { result[i].symbol = NO_SYMBOL; }
+        return result;
+    }
+
+    static u64 find_slot(SymbolIndexSlot* slots, u64 slots_count, Symbol symbol)
+    {
+        auto slot_index = hash_symbol(symbol) >> 32 & (slots_count - 1);
+        while (slots[slot_index].symbol != NO_SYMBOL && slots[slot_index].symbol != symbol)
+        {
+            slot_index = (slot_index + 1) & (slots_count - 1);
+        }
+        return slot_index;
+    }
+
+    void grow()
+    {
+        auto new_slots_count = slots_count * 2;
+        auto new_slots = allocate_slots(new_slots_count);
+        for (u64 i = 0; i < slots_count; i++)
+        {
+            if (slots[i].symbol == NO_SYMBOL) { continue; }
+            new_slots[find_slot(new_slots, new_slots_count, slots[i].symbol)] = slots[i];
+        }
+        default_deallocate(slots);
+        slots = new_slots;
+        slots_count = new_slots_count;
+    }
+};
@@ -0,0 +1,204 @@
+// expression nodes all have the same size and get allocated and freed constantly during reduction, so instead of going
+// through the default allocator they come from a dedicated heap: a free list of node-sized slots on top of big regions
+// of memory requested straight from the OS, which keeps the nodes densely packed and allows backing them with huge
+// pages to cut down on TLB misses while chasing pointers;
+// when a spill file is set, regions are mapped from that file instead of anonymous memory, so terms that grow beyond
+// the physical memory get paged out to disk by the OS rather than getting the process killed, and a resident budget
+// makes the heap evict regions that haven't been allocated from recently
+
+struct TermHeapSettings
+{
+    bool use_huge_pages;
+    bool prefault; // touch every page of a region as soon as it's allocated so that reduction doesn't page fault
+    CStringView spill_file_path; // nullptr if regions shouldn't be backed by a file
+    u64 resident_budget; // in bytes, 0 means there's no budget
+};
+
+const u64 TERM_HEAP_REGION_SIZE = 32 * 1024 * 1024;
+
+struct TermHeapFreeSlot
+{
+    TermHeapFreeSlot* next;
+};
+
+struct TermHeap
+{
+    TermHeapSettings settings;
+    u64 slot_size; // set by the first allocation
+    byte* region_cursor;
+    byte* region_end;
+    TermHeapFreeSlot* free_list;
+    u64 regions_count;
+    List<byte*> regions; // only kept track of when there's a resident budget
+    FileHandle spill_file;
+    u64 spill_file_size;
+    u64 allocations_count; // over the whole run, reused slots included, see Reducer::reduce_head
+
+    // the spill file, if any, gets created right away
+    static Result<TermHeap, String> construct(TermHeapSettings settings)
+    {
+        TermHeap result = {};
+        result.settings = settings;
+        if (settings.spill_file_path != nullptr && !create_temporary_file(settings.spill_file_path, &result.spill_file))
+        {
+            auto error = String::allocate();
+            error.push("Failed to create spill file '");
+            error.push(settings.spill_file_path);
+            error.push("', it mustn't exist yet");
+            return Result<TermHeap, String>::fail(error);
+        }
+        if (settings.resident_budget != 0) { result.regions = List<byte*>::allocate(); }
+        return Result<TermHeap, String>::success(result);
+    }
+
+    byte* allocate(u64 size)
+    {
+        if (slot_size == 0) { slot_size = align_to(sizeof(void*), max(size, (u64)sizeof(TermHeapFreeSlot))); }
+        assert(size <= slot_size, "TermHeap::allocate: all allocations have to be of the same size");
+        allocations_count++;
+
+        if (free_list != nullptr)
+        {
+            auto result = (byte*)free_list;
+            free_list = free_list->next;
+            return result;
+        }
+        if (region_cursor + slot_size > region_end) { allocate_region(); }
+        auto result = region_cursor;
+        region_cursor += slot_size;
+        return result;
+    }
+
+    void deallocate(void* address)
+    {
+        auto slot = (TermHeapFreeSlot*)address;
+        slot->next = free_list;
+        free_list = slot;
+    }
+
+    // takes over the regions of a heap that's done being allocated from (on another thread, see get_thread_term_heap);
+    // allocation goes on in whichever of the two current regions has more room left, the rest of the other one is
+    // never touched, so it doesn't take up any physical memory
+    void adopt(TermHeap* other)
+    {
+        if (other->regions_count == 0)
+        {
+            if (other->settings.resident_budget != 0) { other->regions.deallocate(); }
+            *other = {};
+            return;
+        }
+        if (slot_size == 0) { slot_size = other->slot_size; }
+        assert(slot_size == other->slot_size, "TermHeap::adopt: all allocations have to be of the same size");
+        while (other->free_list != nullptr)
+        {
+            auto slot = other->free_list;
+            other->free_list = slot->next;
+            deallocate(slot);
+        }
+        allocations_count += other->allocations_count;
+        regions_count += other->regions_count;
+
+        auto is_other_region_roomier = other->region_end - other->region_cursor > region_end - region_cursor;
+        if (settings.resident_budget != 0)
+        { // the region that's being allocated from stays the last one
+            byte* current_region = nullptr;
+            if (regions.size != 0 && !is_other_region_roomier)
+            {
+                current_region = regions.data[regions.size - 1];
+                regions.pop();
+            }
+            for (u64 i = 0; i < other->regions.size; i++) { regions.push(other->regions.data[i]); }
+            if (current_region != nullptr) { regions.push(current_region); }
+        }
+        if (is_other_region_roomier)
+        {
+            region_cursor = other->region_cursor;
+            region_end = other->region_end;
+        }
+        if (other->settings.resident_budget != 0) { other->regions.deallocate(); }
+        *other = {};
+    }
+
+private:
+    // regions are never given back to the OS, freed slots get reused instead
+    void allocate_region()
+    {
+        byte* region;
+        if (settings.spill_file_path != nullptr)
+        {
+            region = map_file_pages(spill_file, spill_file_size, TERM_HEAP_REGION_SIZE);
+            assert(region != nullptr, "TermHeap: failed to map memory from the spill file");
+            spill_file_size += TERM_HEAP_REGION_SIZE;
+        }
+        else
+        {
+            region = allocate_pages(TERM_HEAP_REGION_SIZE, settings.use_huge_pages);
+            assert(region != nullptr, "TermHeap: failed to allocate memory");
+        }
+        if (settings.prefault)
+        {
+            for (u64 offset = 0; offset < TERM_HEAP_REGION_SIZE; offset += PAGE_SIZE)
+            {
+                ((volatile byte*)region)[offset] = 0;
+            }
+        }
+        region_cursor = region;
+        region_end = region + TERM_HEAP_REGION_SIZE;
+        regions_count++;
+
+        if (settings.resident_budget != 0)
+        { // new nodes mostly go into the latest regions, so the oldest ones are the coldest
+            regions.push(region);
+            auto resident_regions_count = max(settings.resident_budget / TERM_HEAP_REGION_SIZE, (u64)1);
+            if (regions.size > resident_regions_count)
+            {
+                evict_pages(regions.data[regions.size - resident_regions_count - 1], TERM_HEAP_REGION_SIZE);
+            }
+        }
+    }
+};
+
+TermHeap term_heap = {};
+
+// heaps of the threads other than the main one, see get_thread_term_heap
+ThreadLocal thread_term_heaps = {};
+
+// the heap that nodes get allocated from and freed into on the current thread; the term heap isn't thread safe, so
+// threads other than the main one allocate from heaps of their own, which the term heap adopts once they're done
+TermHeap* get_thread_term_heap()
+{
+    auto heap = (TermHeap*)thread_term_heaps.get();
+    return heap != nullptr ? heap : &term_heap;
+}
+
+// a heap for a thread other than the main one, see get_thread_term_heap; it doesn't spill, since the spill file can
+// only be mapped from by the term heap itself
+TermHeap make_thread_term_heap()
+{
+    TermHeap result = {};
+    result.settings = term_heap.settings;
+    result.settings.spill_file_path = nullptr;
+    if (result.settings.resident_budget != 0) { result.regions = List<byte*>::allocate(); }
+    return result;
+}
+
+// has to be called before any expressions are created; on top of the heap evicting its own old regions, a resident
+// budget puts a hard limit on the memory of the whole process, so it's refused where there's no way to do that
+Result<bool, String> configure_term_heap(TermHeapSettings settings)
+{
+    assert(term_heap.regions_count == 0, "configure_term_heap: the term heap is already in use");
+    if (settings.resident_budget != 0 && !CAN_LIMIT_RESIDENT_MEMORY)
+    {
+        auto error = String::copy_from_c_string("A resident budget isn't supported on this platform");
+        return Result<bool, String>::fail(error);
+    }
+    auto construction_result = TermHeap::construct(settings);
+    if (!construction_result.is_success) { return Result<bool, String>::fail(construction_result.error); }
+    term_heap = construction_result.value;
+    if (settings.resident_budget != 0 && !limit_resident_memory(settings.resident_budget))
+    {
+        auto error = String::copy_from_c_string("Failed to limit the memory to the resident budget");
+        return Result<bool, String>::fail(error);
+    }
+    return Result<bool, String>::success(true);
+}
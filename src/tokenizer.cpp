@@ -5,7 +5,6 @@ enum LcTokenType
     LcTokenTypeCloseParen,
     LcTokenTypeLambdaHeadStart,
     LcTokenTypeLambdaHeadEnd,
-    LcTokenTypeWhitespace,
     LcTokenTypeName,
     LcTokenTypeEquals,
     LcTokenTypeSemicolon,
@@ -19,7 +18,6 @@ const char* to_string(LcTokenType token)
         case LcTokenTypeCloseParen: return "Closing parenthesis";
         case LcTokenTypeLambdaHeadStart: return "Lambda head start";
         case LcTokenTypeLambdaHeadEnd: return "Lambda head end";
-        case LcTokenTypeWhitespace: return "Whitespace";
         case LcTokenTypeName: return "Name";
         case LcTokenTypeEquals: return "Equals sign";
         case LcTokenTypeSemicolon: return "Semicolon";
@@ -27,22 +25,19 @@ const char* to_string(LcTokenType token)
     }
 }
 
+// tokens only say where in the source they are, names get interned by the parser straight from the source; whitespace
+// doesn't get tokens at all, since all it does is separate names, and the tokenizer already does that
 struct Token
 {
-    LcTokenType type;
+    u8 type; // LcTokenType
+    u32 offset;
+    u32 length;
 
-    union
-    {
-        // LcTokenTypeName
-        struct { String name; };
-    };
-
-    void deallocate()
-    {
-        if (type == LcTokenTypeName) { name.deallocate(); }
-    }
+    StringView get_text(String source) { return StringView::construct(length, source.data + offset); }
 };
 
+const u64 MAX_SOURCE_SIZE = (u32)-1; // offsets of tokens have to fit
+
 bool is_whitespace(char c)
 {
     return c == ' ' || c == '\t' || c == '\r' || c == '\n';
@@ -63,16 +58,64 @@ bool is_name_tail(char c)
         || c == '_';
 }
 
+// whitespace and names are the only tokens longer than a character, so the tokenizer spends most of its time looking
+// for where they end; instead of checking every character separately, SSE2 classifies a whole block of them at once into
+// a bit mask, and the end of the run is the lowest bit that's not set; every x64 CPU has SSE2, the scalar version is
+// there for the last few characters that don't fill a block and to compare against
+
+const u64 CHARACTER_BLOCK_SIZE = 16;
+
+// bit i is set if the i-th character of the block is whitespace
+u32 get_whitespace_mask(const char* block)
+{
+    auto characters = _mm_loadu_si128((const __m128i*)block);
+    auto is_whitespace = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(characters, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(characters, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(characters, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(characters, _mm_set1_epi8('\n')))
+    );
+    return (u32)_mm_movemask_epi8(is_whitespace);
+}
+
+// bit i is set if the i-th character of the block can be a part of a name after its first character
+u32 get_name_tail_mask(const char* block)
+{
+    auto characters = _mm_loadu_si128((const __m128i*)block);
+    // comparisons are signed, which works out since none of the characters above 127 are name characters; setting bit
+    // 5 turns upper case letters into lower case ones without turning anything else into a letter
+    auto lower_case_characters = _mm_or_si128(characters, _mm_set1_epi8(0x20));
+    auto is_letter = _mm_and_si128(
+        _mm_cmpgt_epi8(lower_case_characters, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(lower_case_characters, _mm_set1_epi8('z' + 1))
+    );
+    auto is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(characters, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(characters, _mm_set1_epi8('9' + 1))
+    );
+    auto is_underscore = _mm_cmpeq_epi8(characters, _mm_set1_epi8('_'));
+    return (u32)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(is_letter, is_digit), is_underscore));
+}
+
+// bit i is set if the i-th character of the block is a semicolon
+u32 get_semicolon_mask(const char* block)
+{
+    auto characters = _mm_loadu_si128((const __m128i*)block);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(characters, _mm_set1_epi8(';')));
+}
+
+const u32 FULL_CHARACTER_BLOCK_MASK = (1 << CHARACTER_BLOCK_SIZE) - 1;
+
 struct Tokenizer
 {
     String source;
     u64 index;
+    bool use_simd;
 
-    static Tokenizer construct(String source)
+    static Tokenizer construct(String source, bool use_simd)
     {
         Tokenizer result;
         result.source = source;
         result.index = 0;
+        result.use_simd = use_simd;
         return result;
     }
 
@@ -80,63 +123,88 @@ struct Tokenizer
 
     char current() { return source.data[index]; }
 
-    Option<Token> tokenize_open_paren() { return tokenize_character('(', LcTokenTypeOpenParen); }
-
-    Option<Token> tokenize_close_paren() { return tokenize_character(')', LcTokenTypeCloseParen); }
-
-    Option<Token> tokenize_lambda_head_start() { return tokenize_character('\\', LcTokenTypeLambdaHeadStart); }
-
-    Option<Token> tokenize_lambda_head_end() { return tokenize_character('.', LcTokenTypeLambdaHeadEnd); }
-
-    Option<Token> tokenize_equals() { return tokenize_character('=', LcTokenTypeEquals); }
-
-    Option<Token> tokenize_semicolon() { return tokenize_character(';', LcTokenTypeSemicolon); }
-
-    Option<Token> tokenize_whitespace()
+    void skip_whitespace()
     {
-        if (is_done() || !is_whitespace(current()))
+        if (is_done() || !is_whitespace(current())) { return; } // most tokens don't have any whitespace before them
+        if (use_simd)
         {
-            return Option<Token>::empty();
+            while (index + CHARACTER_BLOCK_SIZE <= source.size)
+            {
+                auto end_mask = ~get_whitespace_mask(source.data + index) & FULL_CHARACTER_BLOCK_MASK;
+                if (end_mask != 0)
+                {
+                    index += count_trailing_zeros(end_mask);
+                    return;
+                }
+                index += CHARACTER_BLOCK_SIZE;
+            }
         }
-
-        index++;
         while (!is_done() && is_whitespace(current())) { index++; }
-
-        Token token;
-        token.type = LcTokenTypeWhitespace;
-        return Option<Token>::construct(token);
     }
 
-    Option<Token> tokenize_name()
+    void skip_name_tail()
     {
-        if (is_done() || !is_name_start(current()))
+        if (use_simd)
         {
-            return Option<Token>::empty();
+            while (index + CHARACTER_BLOCK_SIZE <= source.size)
+            {
+                auto end_mask = ~get_name_tail_mask(source.data + index) & FULL_CHARACTER_BLOCK_MASK;
+                if (end_mask != 0)
+                {
+                    index += count_trailing_zeros(end_mask);
+                    return;
+                }
+                index += CHARACTER_BLOCK_SIZE;
+            }
         }
+        while (!is_done() && is_name_tail(current())) { index++; }
+    }
 
-        auto name = String::allocate();
-        name.push(current());
-        index++;
-
-        while (!is_done() && is_name_tail(current()))
+    // moves to the next semicolon, or to the end if there isn't one; semicolons only ever end statements, so this finds
+    // where statements end without tokenizing them, see StatementStream and parse_statements_in_parallel
+    void skip_to_semicolon()
+    {
+        if (use_simd)
         {
-            name.push(current());
-            index++;
+            while (index + CHARACTER_BLOCK_SIZE <= source.size)
+            {
+                auto semicolon_mask = get_semicolon_mask(source.data + index);
+                if (semicolon_mask != 0)
+                {
+                    index += count_trailing_zeros(semicolon_mask);
+                    return;
+                }
+                index += CHARACTER_BLOCK_SIZE;
+            }
         }
-
-        Token token;
-        token.type = LcTokenTypeName;
-        token.name = name;
-        return Option<Token>::construct(token);
+        while (!is_done() && current() != ';') { index++; }
     }
 
-private:
-    Option<Token> tokenize_character(char target_character, LcTokenType target_type)
+    // returns nothing if there's no valid token at the current index, which can't be whitespace
+    Option<Token> tokenize_next()
     {
-        if (is_done() || current() != target_character) { return Option<Token>::empty(); }
-        index++;
         Token token;
-        token.type = target_type;
+        token.offset = index;
+        switch (current())
+        {
+            case '(': token.type = LcTokenTypeOpenParen; break;
+            case ')': token.type = LcTokenTypeCloseParen; break;
+            case '\\': token.type = LcTokenTypeLambdaHeadStart; break;
+            case '.': token.type = LcTokenTypeLambdaHeadEnd; break;
+            case '=': token.type = LcTokenTypeEquals; break;
+            case ';': token.type = LcTokenTypeSemicolon; break;
+            default:
+            {
+                if (!is_name_start(current())) { return Option<Token>::empty(); }
+                index++;
+                skip_name_tail();
+                token.type = LcTokenTypeName;
+                token.length = index - token.offset;
+                return Option<Token>::construct(token);
+            }
+        }
+        index++;
+        token.length = 1;
         return Option<Token>::construct(token);
     }
 };
@@ -149,48 +217,31 @@ struct TokenizationResult
 
     void deallocate()
     {
-        if (success)
-        {
-            for (u64 i = 0; i < tokens.size; i++) { tokens.data[i].deallocate(); }
-            tokens.deallocate();
-        }
+        if (success) { tokens.deallocate(); }
     }
 };
 
-TokenizationResult tokenize(String source)
+// use_simd is only there for comparing against the scalar version
+TokenizationResult tokenize(String source, bool use_simd = true)
 {
-    auto tokenizer = Tokenizer::construct(source);
-
-    auto tokens = List<Token>::allocate();
-    while (!tokenizer.is_done())
+    if (source.size > MAX_SOURCE_SIZE)
     {
-        Option<Token> maybe_token;
-
-        maybe_token = tokenizer.tokenize_open_paren();
-        if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
-
-        maybe_token = tokenizer.tokenize_close_paren();
-        if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
-
-        maybe_token = tokenizer.tokenize_lambda_head_start();
-        if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
-
-        maybe_token = tokenizer.tokenize_lambda_head_end();
-        if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
-
-        maybe_token = tokenizer.tokenize_equals();
-        if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
-
-        maybe_token = tokenizer.tokenize_semicolon();
-        if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
+        TokenizationResult result;
+        result.success = false;
+        result.failed_at_index = MAX_SOURCE_SIZE;
+        return result;
+    }
 
-        maybe_token = tokenizer.tokenize_whitespace();
-        if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
+    auto tokenizer = Tokenizer::construct(source, use_simd);
 
-        maybe_token = tokenizer.tokenize_name();
+    auto tokens = List<Token>::allocate();
+    while (true)
+    {
+        tokenizer.skip_whitespace();
+        if (tokenizer.is_done()) { break; }
+        auto maybe_token = tokenizer.tokenize_next();
         if (maybe_token.has_data) { tokens.push(maybe_token.value); continue; }
 
-        for (u64 i = 0; i < tokens.size; i++) { tokens.data[i].deallocate(); }
         tokens.deallocate();
 
         TokenizationResult result;
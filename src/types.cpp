@@ -0,0 +1,258 @@
+// Hindley-Milner type inference for the simply typed lambda calculus, with definitions being let-polymorphic (every
+// usage of a definition gets its own instance of the definition's type); terms that have a type are strongly
+// normalizing, so reducing them always terminates and the reducer doesn't have to guard against infinite recursion,
+// see interpret; recursive definitions never get a type, since recursion is exactly what breaks that guarantee
+
+const u32 NO_TYPE = (u32)-1;
+
+enum TypeKind
+{
+    TypeKindVariable,
+    TypeKindFunction,
+};
+
+struct Type
+{
+    TypeKind kind;
+    union
+    {
+        // TypeKindVariable
+        u32 instance; // the type this variable has been unified with, NO_TYPE if none
+        // TypeKindFunction
+        struct { u32 parameter; u32 result; };
+    };
+};
+
+struct TypeVariableMapping
+{
+    u32 from;
+    u32 to;
+};
+
+// types refer to each other by their indices in `types`, which is never shrunk, so a type stays valid for as long as
+// the inference does
+struct TypeInference
+{
+    List<Type> types;
+    DefinitionTable definitions;
+    u32* definition_types; // NO_TYPE for definitions that don't have a type
+    List<u32> bound_variable_types; // types of the parameters in scope, the innermost one is last
+
+    static TypeInference allocate(DefinitionTable definitions)
+    {
+        TypeInference result;
+        result.types = List<Type>::allocate();
+        result.definitions = definitions;
+        result.definition_types = (u32*)default_allocate(sizeof(u32) * max(definitions.entries.size, (u64)1));
+        for (u64 i = 0; i < definitions.entries.size; i++) { result.definition_types[i] = NO_TYPE; }
+        result.bound_variable_types = List<u32>::allocate();
+        return result;
+    }
+
+    void deallocate()
+    {
+        types.deallocate();
+        default_deallocate(definition_types);
+        bound_variable_types.deallocate();
+    }
+
+    // infers types of all of the definitions, each one only after the definitions it uses
+    void infer_definition_types()
+    {
+        auto graph = DependencyGraph::allocate(definitions);
+        for (u32 i = 0; i < definitions.entries.size; i++)
+        {
+            if (graph.indices[i] == NOT_VISITED) { graph.visit(i); }
+        }
+
+        auto is_recursive = (bool*)default_allocate(sizeof(bool) * max(definitions.entries.size, (u64)1));
+        set_memory(0, sizeof(bool) * definitions.entries.size, is_recursive);
+        for (u64 i = 0; i < graph.recursive_groups.size; i++)
+        {
+            auto group = graph.recursive_groups.data[i];
+            for (u64 j = 0; j < group.size; j++) { is_recursive[group.data[j]] = true; }
+            group.deallocate();
+        }
+        graph.recursive_groups.deallocate();
+
+        for (u64 i = 0; i < graph.order.size; i++)
+        {
+            auto definition_index = graph.order.data[i];
+            if (is_recursive[definition_index]) { continue; }
+            bound_variable_types.size = 0;
+            definition_types[definition_index] = infer(*definitions.entries.data[definition_index].node);
+        }
+
+        default_deallocate(is_recursive);
+        graph.order.deallocate();
+        graph.deallocate();
+    }
+
+    u32 get_definition_type(Symbol name)
+    {
+        auto maybe_definition_index = definitions.index.get(name);
+        if (!maybe_definition_index.has_data) { return NO_TYPE; }
+        return definition_types[maybe_definition_index.value];
+    }
+
+    // returns NO_TYPE if the expression doesn't have a type
+    u32 infer(Expression expression)
+    {
+        switch (expression.type)
+        {
+            case ExpressionTypeVariable:
+            {
+                if (expression.is_bound)
+                {
+                    return bound_variable_types.data[bound_variable_types.size - expression.bound_index - 1];
+                }
+                auto maybe_definition_index = definitions.index.get(expression.global_name);
+                // globals that aren't defined are opaque constants, they never reduce, so they can be of any type
+                if (!maybe_definition_index.has_data) { return make_variable(); }
+                auto definition_type = definition_types[maybe_definition_index.value];
+                if (definition_type == NO_TYPE) { return NO_TYPE; }
+                return instantiate(definition_type);
+            }
+            case ExpressionTypeFunction:
+            {
+                auto parameter_type = make_variable();
+                bound_variable_types.push(parameter_type);
+                auto body_type = infer(*expression.body);
+                bound_variable_types.pop();
+                if (body_type == NO_TYPE) { return NO_TYPE; }
+                return make_function(parameter_type, body_type);
+            }
+            case ExpressionTypeApplication:
+            {
+                auto function_type = infer(*expression.left);
+                if (function_type == NO_TYPE) { return NO_TYPE; }
+                auto argument_type = infer(*expression.right);
+                if (argument_type == NO_TYPE) { return NO_TYPE; }
+                auto result_type = make_variable();
+                if (!unify(function_type, make_function(argument_type, result_type))) { return NO_TYPE; }
+                return result_type;
+            }
+            default: assert(false); return {};
+        }
+    }
+
+    // type variables are named a, b, c and so on in the order they appear in
+    String to_string(u32 type)
+    {
+        auto result = String::allocate();
+        auto variables = List<u32>::allocate();
+        append_type(type, &variables, &result);
+        variables.deallocate();
+        return result;
+    }
+
+private:
+    u32 make_variable()
+    {
+        Type variable;
+        variable.kind = TypeKindVariable;
+        variable.instance = NO_TYPE;
+        types.push(variable);
+        return types.size - 1;
+    }
+
+    u32 make_function(u32 parameter, u32 result)
+    {
+        Type function;
+        function.kind = TypeKindFunction;
+        function.parameter = parameter;
+        function.result = result;
+        types.push(function);
+        return types.size - 1;
+    }
+
+    // follows variables to the types they've been unified with
+    u32 resolve(u32 type)
+    {
+        while (types.data[type].kind == TypeKindVariable && types.data[type].instance != NO_TYPE)
+        {
+            type = types.data[type].instance;
+        }
+        return type;
+    }
+
+    bool occurs(u32 variable, u32 type)
+    {
+        type = resolve(type);
+        if (type == variable) { return true; }
+        if (types.data[type].kind == TypeKindVariable) { return false; }
+        return occurs(variable, types.data[type].parameter) || occurs(variable, types.data[type].result);
+    }
+
+    bool unify(u32 left, u32 right)
+    {
+        left = resolve(left);
+        right = resolve(right);
+        if (left == right) { return true; }
+        if (types.data[left].kind == TypeKindVariable)
+        {
+            if (occurs(left, right)) { return false; }
+            types.data[left].instance = right;
+            return true;
+        }
+        if (types.data[right].kind == TypeKindVariable) { return unify(right, left); }
+        // both are functions
+        return unify(types.data[left].parameter, types.data[right].parameter)
+            && unify(types.data[left].result, types.data[right].result);
+    }
+
+    // types of definitions are fully generalized, since no type variables are shared between definitions, so an
+    // instance is a copy of the type with all of its variables replaced with fresh ones
+    u32 instantiate(u32 type)
+    {
+        auto mapping = List<TypeVariableMapping>::allocate();
+        auto result = instantiate(type, &mapping);
+        mapping.deallocate();
+        return result;
+    }
+
+    u32 instantiate(u32 type, List<TypeVariableMapping>* mapping)
+    {
+        type = resolve(type);
+        if (types.data[type].kind == TypeKindVariable)
+        {
+            for (u64 i = 0; i < mapping->size; i++)
+            {
+                if (mapping->data[i].from == type) { return mapping->data[i].to; }
+            }
+            TypeVariableMapping variable_mapping;
+            variable_mapping.from = type;
+            variable_mapping.to = make_variable();
+            mapping->push(variable_mapping);
+            return variable_mapping.to;
+        }
+        auto parameter = instantiate(types.data[type].parameter, mapping);
+        auto result = instantiate(types.data[type].result, mapping);
+        return make_function(parameter, result);
+    }
+
+    void append_type(u32 type, List<u32>* variables, String* result)
+    {
+        type = resolve(type);
+        if (types.data[type].kind == TypeKindVariable)
+        {
+            u64 variable_index = 0;
+            while (variable_index != variables->size && variables->data[variable_index] != type) { variable_index++; }
+            if (variable_index == variables->size) { variables->push(type); }
+            if (variable_index < 26) { result->push((char)('a' + variable_index)); }
+            else
+            {
+                result->push('t');
+                result->push(variable_index);
+            }
+            return;
+        }
+        auto parameter = resolve(types.data[type].parameter);
+        auto is_parameter_function = types.data[parameter].kind == TypeKindFunction;
+        if (is_parameter_function) { result->push('('); }
+        append_type(parameter, variables, result);
+        if (is_parameter_function) { result->push(')'); }
+        result->push(" -> ");
+        append_type(types.data[type].result, variables, result);
+    }
+};
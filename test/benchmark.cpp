@@ -0,0 +1,192 @@
+#include "src/include.h"
+
+// benchmarks only report how long each phase took, correctness is checked by the tests
+
+u64 benchmark_phase_start_time;
+
+void start_benchmark_phase() { benchmark_phase_start_time = get_time_in_nanoseconds(); }
+
+void finish_benchmark_phase(const char* name)
+{
+    auto elapsed_microseconds = (get_time_in_nanoseconds() - benchmark_phase_start_time) / 1000;
+    print("    ", name, ": ", elapsed_microseconds, " us\n");
+}
+
+void push_definition_name(String* source, u64 index)
+{
+    source->push("definition_");
+    source->push(index);
+}
+
+// every definition is an identity function, main applies a few of them that are spread out across the whole program
+String generate_program_with_many_definitions(u64 definitions_count)
+{
+    auto result = String::allocate();
+    for (u64 i = 0; i < definitions_count; i++)
+    {
+        push_definition_name(&result, i);
+        result.push(" = \\ x . x;\n");
+    }
+    result.push("main =");
+    u64 used_definitions_count = 50;
+    for (u64 i = 0; i < used_definitions_count; i++)
+    {
+        result.push(' ');
+        push_definition_name(&result, definitions_count - 1 - i * (definitions_count / used_definitions_count));
+    }
+    result.push(";\n");
+    return result;
+}
+
+void benchmark_program_with_many_definitions(u64 definitions_count)
+{
+    print("Program with ", definitions_count, " definitions:\n");
+    auto source = generate_program_with_many_definitions(definitions_count);
+
+    start_benchmark_phase();
+    auto tokenization_result = tokenize(source);
+    finish_benchmark_phase("tokenization");
+    assert(tokenization_result.success);
+
+    start_benchmark_phase();
+    auto parsing_result = parse_statements(source, tokenization_result.tokens);
+    finish_benchmark_phase("parsing");
+    assert(parsing_result.success, parsing_result.error);
+
+    start_benchmark_phase();
+    auto definitions = DefinitionTable::build(parsing_result.statements);
+    finish_benchmark_phase("building definition index");
+    definitions.deallocate();
+
+    start_benchmark_phase();
+    auto interpretation_result = interpret(parsing_result.statements);
+    finish_benchmark_phase("interpretation");
+    assert(interpretation_result.success, interpretation_result.error);
+
+    interpretation_result.deallocate();
+    parsing_result.deallocate();
+    tokenization_result.deallocate();
+    source.deallocate();
+}
+
+// main = f x x x ... x;
+String generate_long_application(u64 arguments_count)
+{
+    auto result = String::allocate();
+    result.push("main = f");
+    for (u64 i = 0; i < arguments_count; i++) { result.push(" x"); }
+    result.push(";\n");
+    return result;
+}
+
+// main = f (f (f ... (f x)...));
+String generate_deep_nesting(u64 depth)
+{
+    auto result = String::allocate();
+    result.push("main = ");
+    for (u64 i = 0; i < depth; i++) { result.push("f ("); }
+    result.push('x');
+    for (u64 i = 0; i < depth; i++) { result.push(')'); }
+    result.push(";\n");
+    return result;
+}
+
+void benchmark_parsing(const char* name, String source)
+{
+    print(name, ":\n");
+
+    start_benchmark_phase();
+    auto tokenization_result = tokenize(source);
+    finish_benchmark_phase("tokenization");
+    assert(tokenization_result.success);
+
+    start_benchmark_phase();
+    auto parsing_result = parse_statements(source, tokenization_result.tokens);
+    finish_benchmark_phase("parsing");
+    assert(parsing_result.success, parsing_result.error);
+
+    parsing_result.deallocate();
+    tokenization_result.deallocate();
+    source.deallocate();
+}
+
+// a program that looks like a real one, but is as big as it needs to be
+String generate_program_of_size(u64 size)
+{
+    auto result = String::allocate(size + 256);
+    for (u64 i = 0; result.size < size; i++)
+    {
+        push_definition_name(&result, i);
+        result.push(" = \\ function argument .\n    function (function argument)");
+        if (i != 0)
+        {
+            result.push(' ');
+            push_definition_name(&result, i - 1);
+        }
+        result.push(";\n\n");
+    }
+    return result;
+}
+
+void benchmark_tokenization(u64 megabytes)
+{
+    print("Tokenizing ", megabytes, " MB:\n");
+    auto source = generate_program_of_size(megabytes * 1000 * 1000);
+    for (u64 i = 0; i < 2; i++)
+    {
+        auto use_simd = i == 1;
+        auto start_time = get_time_in_nanoseconds();
+        auto tokenization_result = tokenize(source, use_simd);
+        auto elapsed_nanoseconds = max(get_time_in_nanoseconds() - start_time, (u64)1);
+        assert(tokenization_result.success);
+        print("    ", use_simd ? "SSE2" : "scalar", ": ", source.size * 1000 / elapsed_nanoseconds, " MB/s\n");
+        tokenization_result.deallocate();
+    }
+    source.deallocate();
+}
+
+void benchmark_parallel_parsing(u64 megabytes)
+{
+    if (!ARE_THREADS_PARALLEL)
+    {
+        print("Parsing in parallel isn't supported on this platform\n");
+        return;
+    }
+    auto threads_count = get_processors_count();
+    print("Parsing ", megabytes, " MB on 1 and ", (u64)threads_count, " threads:\n");
+    auto source = generate_program_of_size(megabytes * 1000 * 1000);
+    for (u64 i = 0; i < 2; i++)
+    {
+        auto is_parallel = i == 1;
+        auto start_time = get_time_in_nanoseconds();
+        ParseStatementsResult parsing_result;
+        if (is_parallel) { parsing_result = parse_statements_in_parallel(source, threads_count); }
+        else
+        {
+            auto tokenization_result = tokenize(source);
+            assert(tokenization_result.success);
+            parsing_result = parse_statements(source, tokenization_result.tokens);
+            tokenization_result.deallocate();
+        }
+        auto elapsed_nanoseconds = get_time_in_nanoseconds() - start_time;
+        assert(parsing_result.success);
+        print("    ", is_parallel ? "parallel" : "single thread", ": ", elapsed_nanoseconds / 1000000, " ms\n");
+        parsing_result.deallocate();
+    }
+    source.deallocate();
+}
+
+int main()
+{
+    benchmark_parsing("Application with 100000 arguments", generate_long_application(100000));
+    benchmark_parsing("Application nested 10000 levels deep", generate_deep_nesting(10000));
+    benchmark_tokenization(4);
+    benchmark_tokenization(32);
+    benchmark_parallel_parsing(32);
+
+    benchmark_program_with_many_definitions(1000);
+    benchmark_program_with_many_definitions(10000);
+    benchmark_program_with_many_definitions(100000);
+
+    print("Done\n");
+}
@@ -4,10 +4,14 @@ Option<Expression> tokenize_and_parse(const char* source_c_string)
 {
     auto source = String::copy_from_c_string(source_c_string);
     auto tokenization_result = tokenize(source);
-    source.deallocate();
-    if (!tokenization_result.success) { return Option<Expression>::empty(); }
-    auto parsing_result = parse_terminal_expression(tokenization_result.tokens);
+    if (!tokenization_result.success)
+    {
+        source.deallocate();
+        return Option<Expression>::empty();
+    }
+    auto parsing_result = parse_terminal_expression(source, tokenization_result.tokens);
     tokenization_result.deallocate();
+    source.deallocate();
     return parsing_result;
 }
 
@@ -15,13 +19,14 @@ ParseStatementsResult tokenize_and_parse_statements(const char* source_c_string)
 {
     auto source = String::copy_from_c_string(source_c_string);
     auto tokenization_result = tokenize(source);
-    source.deallocate();
     if (!tokenization_result.success)
     {
+        source.deallocate();
         return ParseStatementsResult::make_fail(String::copy_from_c_string("Tokenization failed"));
     }
-    auto parsing_result = parse_statements(tokenization_result.tokens);
+    auto parsing_result = parse_statements(source, tokenization_result.tokens);
     tokenization_result.deallocate();
+    source.deallocate();
     return parsing_result;
 }
 
@@ -37,6 +42,32 @@ Result<Expression, String> tokenize_parse_and_reduce(const char* source_c_string
     return reduction_result;
 }
 
+// the SSE2 tokenizer has to give the same tokens as the scalar one, or fail at the same index
+void test_tokenizer(const char* c_string_source)
+{
+    auto source = String::copy_from_c_string(c_string_source);
+    auto scalar_result = tokenize(source, false);
+    auto simd_result = tokenize(source, true);
+    auto are_equal = scalar_result.success == simd_result.success;
+    if (are_equal && scalar_result.success)
+    {
+        are_equal = scalar_result.tokens.size == simd_result.tokens.size;
+        for (u64 i = 0; are_equal && i < scalar_result.tokens.size; i++)
+        {
+            auto scalar_token = scalar_result.tokens.data[i];
+            auto simd_token = simd_result.tokens.data[i];
+            are_equal = scalar_token.type == simd_token.type
+                && scalar_token.offset == simd_token.offset
+                && scalar_token.length == simd_token.length;
+        }
+    }
+    else if (are_equal) { are_equal = scalar_result.failed_at_index == simd_result.failed_at_index; }
+    if (!are_equal) { print("Test failed, SSE2 and scalar tokenizers disagree on:\n", c_string_source, "\n"); }
+    simd_result.deallocate();
+    scalar_result.deallocate();
+    source.deallocate();
+}
+
 void test_parser_success(const char* source, const char* expected)
 {
     auto maybe_expression = tokenize_and_parse(source);
@@ -153,6 +184,180 @@ void test_statements_parser_fail(const char* source, const char* expected_error)
     statements_result.deallocate();
 }
 
+// streaming the statements from a file has to give the same result as parsing them all at once, takes ownership of
+// the source
+void test_statement_stream(String source)
+{
+    auto path = "statement_stream_test.lc";
+    assert(write_whole_file(source, path));
+    auto maybe_file = InputFile::open_file(path);
+    assert(maybe_file.has_data);
+    auto stream_result = parse_statements_from_file(maybe_file.value);
+    maybe_file.value.deallocate();
+    delete_file(path);
+
+    source.make_c_string_compatible();
+    auto expected_result = tokenize_and_parse_statements(source.data);
+    if (stream_result.success != expected_result.success)
+    {
+        print("Test failed, streaming ", stream_result.success ? "succeeded" : "failed", " on statements:\n");
+        print(source, "\nwhile parsing them all at once didn't\n");
+    }
+    else if (stream_result.success)
+    {
+        auto stream_string = to_string(stream_result.statements);
+        auto expected_string = to_string(expected_result.statements);
+        if (!(stream_string == expected_string))
+        {
+            print("Test failed, streamed statements:\n", stream_string, "expected:\n", expected_string);
+        }
+        stream_string.deallocate();
+        expected_string.deallocate();
+    }
+    else if (!contains(expected_result.error.to_string_view(), stream_result.error.to_string_view()))
+    {
+        print("Test failed, streaming error: ", stream_result.error, "\nexpected: ", expected_result.error, "\n");
+    }
+    stream_result.deallocate();
+    expected_result.deallocate();
+    source.deallocate();
+}
+
+void test_statement_stream(const char* source)
+{
+    auto source_string = String::allocate();
+    source_string.push(source);
+    test_statement_stream(source_string);
+}
+
+// parsing on several threads has to give the same result as parsing on one
+void test_parallel_parsing(const char* source, u64 threads_count)
+{
+    auto source_string = String::copy_from_c_string(source);
+    auto parallel_result = parse_statements_in_parallel(source_string, (u32)threads_count);
+    source_string.deallocate();
+
+    auto expected_result = tokenize_and_parse_statements(source);
+    if (parallel_result.success != expected_result.success)
+    {
+        print("Test failed, parsing on ", threads_count, " threads ", parallel_result.success ? "succeeded" : "failed");
+        print(" on statements:\n", source, "\nwhile parsing on one thread didn't\n");
+    }
+    else if (parallel_result.success)
+    {
+        auto parallel_string = to_string(parallel_result.statements);
+        auto expected_string = to_string(expected_result.statements);
+        if (!(parallel_string == expected_string))
+        {
+            print("Test failed, statements parsed on ", threads_count, " threads:\n", parallel_string);
+            print("expected:\n", expected_string);
+        }
+        parallel_string.deallocate();
+        expected_string.deallocate();
+    }
+    else if (!contains(expected_result.error.to_string_view(), parallel_result.error.to_string_view()))
+    {
+        print("Test failed, error of parsing on ", threads_count, " threads: ", parallel_result.error, "\n");
+        print("expected: ", expected_result.error, "\n");
+    }
+    parallel_result.deallocate();
+    expected_result.deallocate();
+}
+
+void test_lazy_parsing(const char* source, const char* expected_statements, const char* expected_error)
+{
+    auto source_string = String::copy_from_c_string(source);
+    auto result = parse_reachable_statements(source_string, symbol_table.intern("main"));
+    source_string.deallocate();
+    if (expected_error == nullptr && !result.success)
+    {
+        print("Test failed, lazy parsing of statements:\n", source, "\nfailed with: ", result.error, "\n");
+    }
+    else if (expected_error != nullptr && result.success)
+    {
+        print("Test failed, lazy parsing of statements:\n", source, "\nsucceeded, expected: ", expected_error, "\n");
+    }
+    else if (result.success)
+    {
+        auto statements_string = to_string(result.statements);
+        if (!(statements_string == expected_statements))
+        {
+            print("Test failed, statements parsed lazily:\n", statements_string);
+            print("expected:\n", expected_statements);
+        }
+        statements_string.deallocate();
+    }
+    else if (!contains(StringView::from_c_string(expected_error), result.error.to_string_view()))
+    {
+        print("Test failed, error of lazy parsing: ", result.error, "\n");
+        print("expected: ", expected_error, "\n");
+    }
+    result.deallocate();
+}
+
+void test_dead_definition_elimination(
+    const char* source,
+    const char* expected_statements,
+    const char* expected_recursive_groups
+)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto recursive_groups = eliminate_dead_definitions(&statements_result.statements, symbol_table.intern("main"));
+
+    auto statements_string = to_string(statements_result.statements);
+    auto recursive_groups_string = String::allocate();
+    for (u64 i = 0; i < recursive_groups.size; i++)
+    {
+        auto group = recursive_groups.data[i];
+        if (i != 0) { recursive_groups_string.push("; "); }
+        for (u64 j = 0; j < group.size; j++)
+        {
+            if (j != 0) { recursive_groups_string.push(' '); }
+            recursive_groups_string.push(symbol_table.get_name(group.data[j]));
+        }
+        group.deallocate();
+    }
+    recursive_groups.deallocate();
+
+    if (statements_string != expected_statements || recursive_groups_string != expected_recursive_groups)
+    {
+        print("Test failed, original statements:\n");
+        print(source);
+        print("expected result:\n");
+        print(expected_statements);
+        print("expected recursive groups: ", expected_recursive_groups, "\n");
+        print("actual result:\n");
+        print(statements_string);
+        print("actual recursive groups: ", recursive_groups_string, "\n");
+    }
+    recursive_groups_string.deallocate();
+    statements_string.deallocate();
+    statements_result.deallocate();
+}
+
+void test_structural_hash(const char* left_source, const char* right_source, bool are_alpha_equivalent)
+{
+    auto maybe_left = tokenize_and_parse(left_source);
+    auto maybe_right = tokenize_and_parse(right_source);
+    assert(maybe_left.has_data && maybe_right.has_data);
+    auto have_same_hash = compute_hash(maybe_left.value) == compute_hash(maybe_right.value);
+    if (have_same_hash != are_alpha_equivalent || (maybe_left.value == maybe_right.value) != are_alpha_equivalent)
+    {
+        print(
+            "Test failed, expressions\n",
+            left_source,
+            "\n",
+            right_source,
+            are_alpha_equivalent
+                ? "\nshould be equal and have the same hash\n"
+                : "\nshouldn't be equal nor have the same hash\n"
+        );
+    }
+    maybe_left.value.deallocate();
+    maybe_right.value.deallocate();
+}
+
 void test_reducer(const char* source, const char* expected)
 {
     auto maybe_reduced = tokenize_parse_and_reduce(source);
@@ -218,7 +423,7 @@ void test_interpreter(const char* c_string_source, const char* expected)
     auto tokenization_result = tokenize(source);
     if (tokenization_result.success)
     {
-        auto parse_result = parse_statements(tokenization_result.tokens);
+        auto parse_result = parse_statements(source, tokenization_result.tokens);
         if (parse_result.success)
         {
             auto interpreter_result = interpret(parse_result.statements);
@@ -296,6 +501,581 @@ void test_interpreter(const char* c_string_source, const char* expected)
     source.deallocate();
 }
 
+void test_interpreter_fail(const char* source, const char* expected_error)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto interpreter_result = interpret(statements_result.statements);
+    if (interpreter_result.success)
+    {
+        print("Test failed, original program:\n", source, "Expected error: ", expected_error, "\nActual result: ");
+        print(interpreter_result.expression, "\n");
+    }
+    else if (!contains(StringView::from_c_string(expected_error), interpreter_result.error.to_string_view()))
+    {
+        print("Test failed, original program:\n", source, "Expected error: ", expected_error, "\n");
+        print("Actual error: ", interpreter_result.error, "\n");
+    }
+    interpreter_result.deallocate();
+    statements_result.deallocate();
+}
+
+// builds a chain of definitions `d_i = <parameters> d_{i - 1} <arguments>;` starting from `d0 = <first>`, with main
+// applying `<main_function>` to the last one, far longer than the recursion limit when the length is
+void test_definition_chain(
+    u64 length,
+    const char* first,
+    const char* parameters,
+    const char* arguments,
+    const char* main_function,
+    const char* expected
+)
+{
+    auto source = String::allocate();
+    source.push("d0 = ");
+    source.push(first);
+    source.push(";\n");
+    for (u64 i = 1; i < length; i++)
+    {
+        source.push('d');
+        source.push(i);
+        source.push(" = ");
+        source.push(parameters);
+        source.push(" d");
+        source.push(i - 1);
+        source.push(' ');
+        source.push(arguments);
+        source.push(";\n");
+    }
+    source.push("main = ");
+    source.push(main_function);
+    source.push(" d");
+    source.push(length - 1);
+    source.push(";\n");
+    auto tokenization_result = tokenize(source);
+    assert(tokenization_result.success);
+    auto statements_result = parse_statements(source, tokenization_result.tokens);
+    assert(statements_result.success);
+
+    auto interpreter_result = interpret(statements_result.statements);
+    auto result_string = interpreter_result.success
+        ? interpreter_result.expression.to_string()
+        : interpreter_result.error.copy();
+    if (result_string != expected)
+    {
+        print("Test failed, a chain of ", length, " definitions `", parameters, " d_i-1 ");
+        print(arguments, "` applied to `", main_function, "`, expected result: ", expected);
+        print(", actual result: ", result_string, "\n");
+    }
+    result_string.deallocate();
+    interpreter_result.deallocate();
+    statements_result.deallocate();
+    tokenization_result.deallocate();
+    source.deallocate();
+}
+
+// main is a function whose body applies its first parameter to `length` arguments, which it normalizes to itself
+void test_long_spine(u64 length)
+{
+    auto expected = String::allocate();
+    expected.push("\\ f x . f");
+    for (u64 i = 0; i < length; i++) { expected.push(" x"); }
+    auto source = String::allocate();
+    source.push("main = ");
+    source.push(expected);
+    source.push(";\n");
+    auto tokenization_result = tokenize(source);
+    assert(tokenization_result.success);
+    auto statements_result = parse_statements(source, tokenization_result.tokens);
+    assert(statements_result.success);
+
+    auto interpreter_result = interpret(statements_result.statements);
+    auto result_string = interpreter_result.success
+        ? interpreter_result.expression.to_string()
+        : interpreter_result.error.copy();
+    if (!(result_string == expected))
+    {
+        print("Test failed, a function applying its parameter to ", length, " arguments didn't normalize to itself, ");
+        print("actual result: ", result_string, "\n");
+    }
+    result_string.deallocate();
+    interpreter_result.deallocate();
+    statements_result.deallocate();
+    tokenization_result.deallocate();
+    source.deallocate();
+    expected.deallocate();
+}
+
+void test_folding(const char* source, const char* expected)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto interpreter_result = interpret(statements_result.statements, &statements_result.statements);
+    assert(interpreter_result.success);
+    auto result_string = interpreter_result.expression.to_string();
+    if (result_string != expected)
+    {
+        print("Test failed, original program:\n", source, "Expected result: ", expected, "\nActual result: ");
+        print(result_string, "\n");
+    }
+    result_string.deallocate();
+    interpreter_result.deallocate();
+    statements_result.deallocate();
+}
+
+void test_optimization_pass(OptimizationPass pass, const char* source, const char* expected)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto settings = OptimizationSettings::construct(symbol_table.intern("main"));
+    for (u64 i = 0; i < OPTIMIZATION_PASSES_COUNT; i++) { settings.is_pass_enabled[i] = i == pass; }
+    optimize(&statements_result.statements, settings).deallocate();
+
+    auto statements_string = to_string(statements_result.statements);
+    if (statements_string != expected)
+    {
+        print("Test failed, ", OPTIMIZATION_PASS_NAMES[pass], " of statements:\n");
+        print(source);
+        print("expected result:\n");
+        print(expected);
+        print("actual result:\n");
+        print(statements_string);
+    }
+    statements_string.deallocate();
+    statements_result.deallocate();
+}
+
+// all of the passes together must not change what main reduces to
+void test_optimizations_preserve_result(const char* source)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto original_result = interpret(statements_result.statements);
+    assert(original_result.success);
+    optimize(&statements_result.statements, OptimizationSettings::construct(symbol_table.intern("main"))).deallocate();
+    auto optimized_result = interpret(statements_result.statements);
+    if (!optimized_result.success || optimized_result.expression != original_result.expression)
+    {
+        print("Test failed, optimizations changed the result of program:\n", source);
+    }
+    optimized_result.deallocate();
+    original_result.deallocate();
+    statements_result.deallocate();
+}
+
+// runs the program once to profile it and checks that the profile survives being saved and loaded, then that
+// optimizing the program as if all of its definitions were hot doesn't change the result; unfolded_definition has to
+// be unfolded at least once during the run
+void test_profile(const char* source, const char* unfolded_definition)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto profile = Profile::allocate();
+    auto original_result = interpret(statements_result.statements, nullptr, &profile);
+    assert(original_result.success);
+    auto unfolded_entry = profile.find(symbol_table.intern(unfolded_definition));
+    if (unfolded_entry == nullptr || unfolded_entry->unfolds_count == 0)
+    {
+        print("Test failed, expected definition ", unfolded_definition, " to be unfolded in the profile of program:\n");
+        print(source);
+    }
+
+    auto profile_source = profile.serialize();
+    auto maybe_loaded_profile = Profile::parse(profile_source);
+    assert(maybe_loaded_profile.has_data);
+    auto loaded_profile = maybe_loaded_profile.value;
+    auto loaded_profile_source = loaded_profile.serialize();
+    if (!(loaded_profile_source == profile_source))
+    {
+        print("Test failed, profile changed after being saved and loaded:\n");
+        print("expected:\n", profile_source, "actual:\n");
+        print(loaded_profile_source);
+    }
+
+    auto hot_profile = Profile::allocate();
+    for (u64 i = 0; i < statements_result.statements.size; i++)
+    {
+        hot_profile.set(statements_result.statements.data[i].name, HOT_UNFOLDS_COUNT, 0);
+    }
+    auto settings = OptimizationSettings::construct(symbol_table.intern("main"));
+    settings.profile = &hot_profile;
+    optimize(&statements_result.statements, settings).deallocate();
+    auto optimized_result = interpret(statements_result.statements);
+    if (!optimized_result.success || optimized_result.expression != original_result.expression)
+    {
+        print("Test failed, profile guided optimizations changed the result of program:\n", source);
+    }
+
+    optimized_result.deallocate();
+    hot_profile.deallocate();
+    loaded_profile_source.deallocate();
+    loaded_profile.deallocate();
+    profile_source.deallocate();
+    original_result.deallocate();
+    profile.deallocate();
+    statements_result.deallocate();
+}
+
+// runs the program the way main does with --profile, twice, and checks that the profile from the first run makes the
+// second one optimize hot_definition differently without changing the result
+void test_profile_guided_optimization(const char* source, const char* hot_definition)
+{
+    auto first_statements_result = tokenize_and_parse_statements(source);
+    auto second_statements_result = tokenize_and_parse_statements(source);
+    assert(first_statements_result.success && second_statements_result.success);
+    auto profile = Profile::allocate();
+    auto settings = OptimizationSettings::construct(symbol_table.intern("main"));
+    settings.profile = &profile;
+
+    optimize(&first_statements_result.statements, settings).deallocate();
+    auto first_result = interpret(first_statements_result.statements, nullptr, &profile);
+    assert(first_result.success);
+    if (!profile.is_hot(symbol_table.intern(hot_definition)))
+    {
+        print("Test failed, expected definition ", hot_definition, " to be hot in the profile of program:\n", source);
+    }
+
+    optimize(&second_statements_result.statements, settings).deallocate();
+    auto first_program_string = to_string(first_statements_result.statements);
+    auto second_program_string = to_string(second_statements_result.statements);
+    if (first_program_string == second_program_string)
+    {
+        print("Test failed, the profile didn't change how the program was optimized:\n", source);
+    }
+    auto second_result = interpret(second_statements_result.statements, nullptr, &profile);
+    if (!second_result.success || second_result.expression != first_result.expression)
+    {
+        print("Test failed, profile guided optimizations changed the result of program:\n", source);
+    }
+
+    second_result.deallocate();
+    second_program_string.deallocate();
+    first_program_string.deallocate();
+    first_result.deallocate();
+    profile.deallocate();
+    second_statements_result.deallocate();
+    first_statements_result.deallocate();
+}
+
+void test_type_inference(const char* source, const char* expected_types)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto definitions = DefinitionTable::build(statements_result.statements);
+    auto type_inference = TypeInference::allocate(definitions);
+    type_inference.infer_definition_types();
+
+    auto types_string = String::allocate();
+    for (u64 i = 0; i < definitions.entries.size; i++)
+    {
+        types_string.push(symbol_table.get_name(definitions.entries.data[i].name));
+        types_string.push(" : ");
+        auto type = type_inference.definition_types[i];
+        if (type == NO_TYPE) { types_string.push("no type"); }
+        else
+        {
+            auto type_string = type_inference.to_string(type);
+            types_string.push(type_string);
+            type_string.deallocate();
+        }
+        types_string.push('\n');
+    }
+    if (types_string != expected_types)
+    {
+        print("Test failed, types of statements:\n");
+        print(source);
+        print("expected types:\n");
+        print(expected_types);
+        print("actual types:\n");
+        print(types_string);
+    }
+
+    types_string.deallocate();
+    type_inference.deallocate();
+    definitions.deallocate();
+    statements_result.deallocate();
+}
+
+// expected strictness has a letter per parameter of each definition, S for strict ones and L for lazy ones
+void test_strictness(const char* source, const char* expected_strictness)
+{
+    auto statements_result = tokenize_and_parse_statements(source);
+    assert(statements_result.success);
+    auto definitions = DefinitionTable::build(statements_result.statements);
+    analyze_strictness(definitions);
+
+    auto strictness_string = String::allocate();
+    for (u64 i = 0; i < definitions.entries.size; i++)
+    {
+        strictness_string.push(symbol_table.get_name(definitions.entries.data[i].name));
+        strictness_string.push(" :");
+        for (auto function = definitions.entries.data[i].node;
+            function->type == ExpressionTypeFunction;
+            function = function->body)
+        {
+            strictness_string.push(function->is_parameter_strict ? " S" : " L");
+        }
+        strictness_string.push('\n');
+    }
+    if (strictness_string != expected_strictness)
+    {
+        print("Test failed, strictness of statements:\n");
+        print(source);
+        print("expected strictness:\n");
+        print(expected_strictness);
+        print("actual strictness:\n");
+        print(strictness_string);
+    }
+
+    strictness_string.deallocate();
+    definitions.deallocate();
+    statements_result.deallocate();
+}
+
+void test_normal_form_cache()
+{
+    auto statements_result = tokenize_and_parse_statements(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "one = succ zero;\n"
+        "two = succ one;\n"
+        "main = two;\n"
+    );
+    assert(statements_result.success);
+    auto definitions = DefinitionTable::build(statements_result.statements);
+    auto main_name = symbol_table.intern("main");
+    auto one_name = symbol_table.intern("one");
+
+    auto first_result = interpret(definitions, *definitions.find(main_name));
+    assert(first_result.success);
+    if (definitions.get(one_name)->normal_form_state != NormalFormStateKnown)
+    {
+        print("Test failed, normal form of 'one' wasn't cached after being used\n");
+    }
+    first_result.deallocate();
+
+    // 'two' was cached using the old definition of 'one', so it has to be recomputed
+    auto maybe_new_one = tokenize_and_parse("succ (succ zero)");
+    assert(maybe_new_one.has_data);
+    definitions.define(one_name, maybe_new_one.value);
+    auto second_result = interpret(definitions, *definitions.find(main_name));
+    assert(second_result.success);
+    auto second_result_string = second_result.expression.to_string();
+    if (second_result_string != "\\ f x . f (f (f x))")
+    {
+        print("Test failed, expected result after redefinition: \\ f x . f (f (f x))\nActual result: ");
+        print(second_result_string, "\n");
+    }
+    second_result_string.deallocate();
+    second_result.deallocate();
+
+    // the normal form is computed from where the unfolding that demanded it was, and running out of depth there
+    // doesn't count as not having one, so it's computed again once the definition is unfolded from further up
+    auto two_name = symbol_table.intern("two");
+    definitions.get(two_name)->invalidate_normal_form();
+    auto maybe_two = tokenize_and_parse("two");
+    assert(maybe_two.has_data);
+    auto reducer = Reducer::construct(definitions);
+    auto deep_result = reducer.reduce_head(to_node(copy(maybe_two.value)), RECURSION_LIMIT - 1);
+    if (deep_result.is_success) { drop(deep_result.value); }
+    else { deep_result.error.deallocate(); }
+    if (definitions.get(two_name)->normal_form_state != NormalFormStateUnknown)
+    {
+        print("Test failed, normal form of 'two' was given up on after being unfolded close to the recursion limit\n");
+    }
+    auto shallow_result = reducer.reduce_head(to_node(maybe_two.value), 0);
+    assert(shallow_result.is_success);
+    drop(shallow_result.value);
+    if (definitions.get(two_name)->normal_form_state != NormalFormStateKnown)
+    {
+        print("Test failed, normal form of 'two' wasn't cached after being unfolded from the top\n");
+    }
+
+    definitions.deallocate();
+    statements_result.deallocate();
+
+    // recursive definitions are unfolded as they are, without trying to normalize them first
+    auto recursive_statements_result = tokenize_and_parse_statements(
+        "count = \\ n . n (\\ p . count p) z;\n"
+        "main = count (\\ f x . x);\n"
+    );
+    assert(recursive_statements_result.success);
+    auto recursive_definitions = DefinitionTable::build(recursive_statements_result.statements);
+    mark_recursive_definitions(recursive_definitions);
+    auto recursive_result = interpret(recursive_definitions, *recursive_definitions.find(main_name));
+    assert(recursive_result.success);
+    auto recursive_result_string = recursive_result.expression.to_string();
+    if (recursive_result_string != "z")
+    {
+        print("Test failed, expected result of a recursive definition: z\n");
+        print("Actual result: ", recursive_result_string, "\n");
+    }
+    recursive_result_string.deallocate();
+    if (recursive_definitions.get(symbol_table.intern("count"))->normal_form_state != NormalFormStateMissing)
+    {
+        print("Test failed, a recursive definition had its normal form computed\n");
+    }
+    recursive_result.deallocate();
+    recursive_definitions.deallocate();
+    recursive_statements_result.deallocate();
+}
+
+// links that a deallocated table left in the statements must not be followed
+void test_stale_definition_links()
+{
+    auto statements_result = tokenize_and_parse_statements("id = \\ x . x;\nmain = id y;\n");
+    assert(statements_result.success);
+    auto definitions = DefinitionTable::build(statements_result.statements);
+    definitions.deallocate();
+    auto main_expression = statements_result.statements.data[1].expression;
+    auto reducing_result = reduce(main_expression);
+    assert(reducing_result.is_success);
+    if (reducing_result.value != main_expression)
+    {
+        print("Test failed, a global was unfolded through the link of a deallocated table\n");
+    }
+    reducing_result.value.deallocate();
+    statements_result.deallocate();
+}
+
+// the consuming variant has to give the same result whether or not it's the only owner of the expression, and mustn't
+// modify nodes that are shared with someone else
+void test_reduce_in_place(const char* source, const char* expected)
+{
+    auto maybe_expression = tokenize_and_parse(source);
+    assert(maybe_expression.has_data);
+    auto node = to_node(maybe_expression.value);
+    auto original_string = node->to_string();
+
+    auto shared_result = reduce_in_place(dup(node));
+    assert(shared_result.is_success);
+    auto shared_result_string = shared_result.value->to_string();
+    auto node_string = node->to_string();
+    if (shared_result_string != expected || !(node_string == original_string))
+    {
+        print("Test failed, reducing a shared expression in place: ", source, ", expected result: ", expected);
+        print(", actual result: ", shared_result_string, ", original expression afterwards: ", node_string, "\n");
+    }
+    node_string.deallocate();
+    shared_result_string.deallocate();
+    drop(shared_result.value);
+
+    auto unique_result = reduce_in_place(node);
+    assert(unique_result.is_success);
+    auto unique_result_string = unique_result.value->to_string();
+    if (unique_result_string != expected)
+    {
+        print("Test failed, reducing a unique expression in place: ", source, ", expected result: ", expected);
+        print(", actual result: ", unique_result_string, "\n");
+    }
+    unique_result_string.deallocate();
+    drop(unique_result.value);
+    original_string.deallocate();
+}
+
+// allocates from a heap of its own until it needs a second region, slots have to be handed out back to back and stay
+// intact, and freed slots have to be handed out again before any new ones
+void test_term_heap(TermHeapSettings settings)
+{
+    TermHeap heap = {};
+    heap.settings = settings;
+    auto first = (u64*)heap.allocate(sizeof(Expression));
+    auto second = (u64*)heap.allocate(sizeof(Expression));
+    if ((byte*)second - (byte*)first != (s64)heap.slot_size || heap.slot_size < sizeof(Expression))
+    {
+        print("Test failed, term heap slots aren't consecutive slots of at least the size of an expression\n");
+    }
+    *first = 1;
+    *second = 2;
+
+    heap.deallocate(first);
+    if ((u64*)heap.allocate(sizeof(Expression)) != first)
+    {
+        print("Test failed, a freed term heap slot wasn't reused\n");
+    }
+    *first = 1;
+
+    auto last = second;
+    while (heap.regions_count == 1) { last = (u64*)heap.allocate(sizeof(Expression)); }
+    *last = 3;
+    if (*first != 1 || *second != 2 || *last != 3)
+    {
+        print("Test failed, term heap slots were overwritten by other allocations\n");
+    }
+    if ((byte*)last >= (byte*)first && (byte*)last < (byte*)first + TERM_HEAP_REGION_SIZE)
+    {
+        print("Test failed, the term heap allocated past the end of its region\n");
+    }
+    if (heap.allocations_count != 4 + TERM_HEAP_REGION_SIZE / heap.slot_size - 2)
+    {
+        print("Test failed, expected ", 4 + TERM_HEAP_REGION_SIZE / heap.slot_size - 2, " term heap allocations, ");
+        print("actual count: ", heap.allocations_count, "\n");
+    }
+}
+
+// fills a few regions of a heap backed by a spill file with a resident budget of a single region, so the older regions
+// get evicted to the file, and everything has to read back the same
+void test_spill_file()
+{
+    TermHeapSettings settings = {};
+    settings.spill_file_path = "lci_test_spill_file";
+    settings.resident_budget = TERM_HEAP_REGION_SIZE;
+    auto construction_result = TermHeap::construct(settings);
+    if (!construction_result.is_success)
+    {
+        print("Test failed, couldn't create a term heap with a spill file: ", construction_result.error, "\n");
+        construction_result.error.deallocate();
+        return;
+    }
+    auto heap = construction_result.value;
+    auto slots = List<u64*>::allocate();
+    while (heap.regions_count < 3)
+    {
+        auto slot = (u64*)heap.allocate(sizeof(Expression));
+        *slot = slots.size;
+        slots.push(slot);
+    }
+    if (heap.spill_file_size != 3 * TERM_HEAP_REGION_SIZE || heap.regions.size != 3)
+    {
+        print("Test failed, expected 3 regions mapped from the spill file, actual count: ", heap.regions.size, "\n");
+    }
+    for (u64 i = 0; i < slots.size; i++)
+    {
+        if (*slots.data[i] != i)
+        {
+            print("Test failed, a term heap slot read back wrong after being spilled: ", *slots.data[i], "\n");
+            break;
+        }
+    }
+    slots.deallocate();
+    heap.regions.deallocate();
+}
+
+// a spill file can't take the place of a file that's already there, which has to be left as it was
+void test_existing_spill_file()
+{
+    auto path = "lci_test_existing_spill_file";
+    auto contents = String::copy_from_c_string("contents");
+    assert(write_whole_file(contents, path));
+    TermHeapSettings settings = {};
+    settings.spill_file_path = path;
+    auto construction_result = TermHeap::construct(settings);
+    if (construction_result.is_success)
+    {
+        print("Test failed, a term heap got a spill file where there already was a file\n");
+        construction_result.value.regions.deallocate();
+    }
+    else { construction_result.error.deallocate(); }
+    auto maybe_read_contents = read_whole_file(path);
+    if (!maybe_read_contents.has_data || !(maybe_read_contents.value == contents))
+    {
+        print("Test failed, a file got overwritten by a spill file\n");
+    }
+    if (maybe_read_contents.has_data) { maybe_read_contents.value.deallocate(); }
+    contents.deallocate();
+    delete_file(path);
+}
+
 int main()
 {
     test_parser_success("a");
@@ -321,6 +1101,14 @@ int main()
     test_parser_fail("\\ a b b c . z");
     test_parser_fail("\\ x . \\ y . \\ x . z");
     test_parser_fail("\\ x . \\ y . \\ y . z");
+    test_parser_success("f a \\ x . x b", "f a (\\ x . x b)");
+    test_parser_success("(f (\\ x . (x (\\ y . y))) a) b", "f (\\ x . x (\\ y . y)) a b");
+    test_parser_fail("()");
+    test_parser_fail("(a b");
+    test_parser_fail("a b)");
+    test_parser_fail("\\ . a");
+    test_parser_fail("\\ x y a");
+    test_parser_fail("(\\ x . ) a");
 
     test_statements_parser_success("zero = \\ f x . x;\n");
     test_statements_parser_success(
@@ -338,6 +1126,113 @@ int main()
         "zero = hey hey;\n",
         "duplicate definition"
     );
+    test_statements_parser_fail("main = \\ x . x", "encountered end of file");
+    test_statement_stream("  \n\t");
+    test_statement_stream("zero = \\ f x . x;\none = \\ f x . f x;\n\nmain = one zero;\n");
+    test_statement_stream("zero = \\ f x . x;\nmain = zero");
+    test_statement_stream("zero = \\ f x . x;\nzero = zero;");
+    // statements that don't fit into a single chunk
+    auto long_source = String::allocate();
+    for (u64 i = 0; long_source.size < 3 * STREAM_CHUNK_SIZE; i++)
+    {
+        long_source.push("definition_");
+        long_source.push(i);
+        long_source.push(" = \\ x . x;                  \n");
+        if (i % 1000 == 0)
+        {
+            long_source.push("long_");
+            long_source.push(i);
+            long_source.push(" = \\ x . x");
+            for (u64 j = 0; j < STREAM_CHUNK_SIZE / 4; j++) { long_source.push(" x"); }
+            long_source.push(";\n");
+        }
+    }
+    test_statement_stream(long_source);
+    // errors past the first chunk, after the parsed statements have been thrown away
+    auto failing_source = String::allocate();
+    for (u64 i = 0; failing_source.size < 2 * STREAM_CHUNK_SIZE + 100; i++)
+    {
+        failing_source.push("d");
+        failing_source.push(i);
+        failing_source.push(" = \\ x . x;\n");
+    }
+    failing_source.push("failing = x $;\n");
+    test_statement_stream(failing_source);
+    const char* parallel_parsing_sources[] = {
+        "zero = \\ f x . x;\none = \\ f x . f x;\ntwo = \\ f x . f (f x);\nmain = two one zero;\n\n",
+        "a = \\ x . x;\nb = a;\nc = \\ b . b;\nd = c;",
+        "a = \\ x . x;\nb = a;\nc = \\ d . d;\nd = c;",
+        "a = \\ x . x;\nb = a;\nc = b;\nb = c;",
+        "a = \\ x . x;\nb = a;\nc = b;\nd = (c;\nc = d;",
+        "a = \\ x . x;\nb = a;\nc = b $;\nd = (c;",
+        "a = \\ x . x;\nb = a;\n;\nc = b;",
+        "a = \\ x . x;\nb = a;\nc = b",
+    };
+    for (u64 i = 0; i < sizeof(parallel_parsing_sources) / sizeof(const char*); i++)
+    {
+        for (u64 threads_count = 1; threads_count <= 5; threads_count++)
+        {
+            test_parallel_parsing(parallel_parsing_sources[i], threads_count);
+        }
+    }
+
+    test_lazy_parsing(
+        "zero = \\ f x . x;\n"
+        "unused = zero zero;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "main = succ zero;\n",
+        "zero = \\ f x . x;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "main = succ zero;\n",
+        nullptr
+    );
+    test_lazy_parsing(
+        "main = loop a;\n"
+        "broken = \\ . (;\n"
+        "loop = \\ x . loop x;\n",
+        "main = loop a;\n"
+        "loop = \\ x . loop x;\n",
+        nullptr
+    );
+    test_lazy_parsing("a = b;\nb = \\ . x;\nmain = a;\n", nullptr, "Parsing failed");
+    test_lazy_parsing("a = b;\nb = x $;\nmain = a;\n", nullptr, "Tokenization failed at character 13");
+    test_lazy_parsing("a = x;\nb = x;\na = y;\nmain = b;\n", nullptr, "Encountered duplicate definition: a");
+    test_lazy_parsing("a = \\ x . x;\n", "", nullptr);
+
+    test_structural_hash("\\ x . x", "\\ y . y", true);
+    test_structural_hash("\\ x y . x y z", "\\ a b . a b z", true);
+    test_structural_hash("\\ x y . x", "\\ x y . y", false);
+    test_structural_hash("\\ x . x z", "\\ x . x y", false);
+    test_structural_hash("a (b c)", "a b c", false);
+
+    test_dead_definition_elimination(
+        "zero = \\ f x . x;\n"
+        "unused = zero zero;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "main = succ zero;\n",
+        "succ = \\ n f x . f (n f x);\n"
+        "zero = \\ f x . x;\n"
+        "main = succ zero;\n",
+        ""
+    );
+    test_dead_definition_elimination(
+        "main = loop a;\n"
+        "even = \\ n . odd n;\n"
+        "odd = \\ n . even n;\n"
+        "loop = \\ x . loop x;\n",
+        "loop = \\ x . loop x;\n"
+        "main = loop a;\n",
+        "loop"
+    );
+    test_dead_definition_elimination(
+        "odd = \\ n . even n;\n"
+        "even = \\ n . odd n;\n"
+        "main = even zero;\n",
+        "even = \\ n . odd n;\n"
+        "odd = \\ n . even n;\n"
+        "main = even zero;\n",
+        "even odd"
+    );
 
     test_reducer("x", "x");
     test_reducer("(\\ x . x) value", "value");
@@ -354,12 +1249,20 @@ int main()
     test_reducer("(\\ y x . x y) x", "\\ x_1 . x_1 x");
     test_reducer("(\\ y x . x y) x y", "y x");
     test_reducer("(\\ g y x . y x g) x (\\ a b x . a x b)", "\\ x_1 x_2 . x_1 x_2 x");
+    // the argument refers to a variable bound outside of the redex, so it has to be shifted when substituted under a
+    // binder
+    test_reducer("(\\ y . (\\ x z . x) y) a b", "a");
     // make sure the interpreter doesn't crash on infinite recursion, and instead gives a proper error message
     test_reducer_fail("(\\ x . x x) (\\ x . x x)", "recursion limit");
     // this is infinite recursion inside of a function, so should it be evaluated at all?
     // test_reducer("\\ _ . (\\ x . x x) (\\ x . x x)", "\\ _ . (\\ x . x x) (\\ x . x x)");
-    // this infinite recursion can get eaten up by the application at the beginning of the expression, so, again, should this crash?
-    // test_reducer("(\\ _ x . x) ((\\ x . x x) (\\ x . x x))", "\\ x . x");
+    // this infinite recursion gets eaten up by the application at the beginning of the expression, arguments of unused
+    // parameters are never reduced
+    test_reducer("(\\ _ x . x) ((\\ x . x x) (\\ x . x x))", "\\ x . x");
+
+    test_reduce_in_place("(\\ x y . y x) (\\ y . y)", "\\ y . y (\\ y_1 . y_1)");
+    test_reduce_in_place("(\\ x . x x) y z", "y y z");
+    test_reduce_in_place("\\ a . (\\ x y . x y) a (b c)", "\\ a . a (b c)");
     // see below for another instance of this problem
 
     test_interpreter(
@@ -382,6 +1285,23 @@ int main()
         "main = add one two;\n",
         "three"
     );
+    // globals are only unfolded once they end up in head position, so a diverging definition that gets thrown away is
+    // never even looked at
+    test_interpreter(
+        "omega = (\\ x . x x) (\\ x . x x);\n"
+        "const = \\ x y . x;\n"
+        "main = const value omega;\n",
+        "value"
+    );
+    // mutually recursive definitions refer to each other through links to their shared nodes
+    test_interpreter(
+        "true = \\ iftrue iffalse . iftrue;\n"
+        "false = \\ iftrue iffalse . iffalse;\n"
+        "even = \\ b . b (odd false) yes;\n"
+        "odd = \\ b . b (even false) no;\n"
+        "main = even true;\n",
+        "no"
+    );
     // in this test we don't start a recursive function by not applying anything to it
     // test_interpreter(
     //     "true = \\ iftrue iffalse . iftrue;\n"
@@ -401,5 +1321,263 @@ int main()
         "\\ x . x"
     );
 
+    test_normal_form_cache();
+    // well typed programs are reduced without the recursion limit, but they still mustn't overflow the stack
+    test_interpreter_fail(
+        "five = \\ f x . f (f (f (f (f x))));\n"
+        "ten = \\ f x . f (f (f (f (f (f (f (f (f (f x)))))))));\n"
+        "exp = \\ b e . e b;\n"
+        "main = exp ten five;\n",
+        "Stack limit of 524288 bytes reached"
+    );
+    test_stale_definition_links();
+    // unfolding each of these computes the normal form of the one before it, and so on, far deeper than the recursion
+    // limit; main isn't well typed, so the reduction is guarded
+    test_definition_chain(30000, "\\ y z . y", "\\ y z .", "z y", "(\\ a b . b) (\\ x . x x)", "\\ y z . z");
+    // unfolding globals in head position doesn't count towards the recursion limit
+    test_definition_chain(10000, "\\ x . x", "\\ y .", "y", "(\\ a b . b a) (\\ x . x x)", "\\ x . x x");
+    // the same chain without the ill typed function is reduced unguarded, where it used to run out of stack
+    test_definition_chain(30000, "\\ y z . y", "\\ y z .", "z y", "", "\\ y z . z");
+    // long enough to run out of stack if the arguments of a stuck head were reduced recursively
+    test_long_spine(5000);
+
+    TermHeapSettings term_heap_settings = {};
+    test_term_heap(term_heap_settings);
+    term_heap_settings.prefault = true;
+    test_term_heap(term_heap_settings);
+    term_heap_settings.use_huge_pages = true; // falls back to transparent huge pages when none are reserved
+    test_term_heap(term_heap_settings);
+    test_spill_file();
+    test_existing_spill_file();
+
+    test_type_inference(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "id = \\ x . x;\n"
+        "pair = \\ first second f . f first second;\n"
+        "main = pair (id id) (id zero);\n"
+        "loop = \\ x . loop x;\n"
+        "omega = (\\ x . x x) (\\ x . x x);\n"
+        "uses_loop = \\ x . loop x;\n",
+        "zero : a -> b -> b\n"
+        "succ : ((a -> b) -> c -> a) -> (a -> b) -> c -> b\n"
+        "id : a -> a\n"
+        "pair : a -> b -> (a -> b -> c) -> c\n"
+        "main : ((a -> a) -> (b -> c -> c) -> d) -> d\n"
+        "loop : no type\n"
+        "omega : no type\n"
+        "uses_loop : no type\n"
+    );
+    // well typed programs are reduced without the recursion limit, this one goes way deeper than it
+    {
+        auto statements_result = tokenize_and_parse_statements(
+            "zero = \\ f x . x;\n"
+            "succ = \\ n f x . f (n f x);\n"
+            "two = succ (succ zero);\n"
+            "three = succ two;\n"
+            "mul = \\ m n f . m (n f);\n"
+            "main = mul three three two;\n"
+        );
+        assert(statements_result.success);
+        auto interpreter_result = interpret(statements_result.statements);
+        // 2 to the power of 9 is \ f x . f (f (... x)) with 512 applications
+        if (!interpreter_result.success || get_size(interpreter_result.expression) != 2 + 512 + 513)
+        {
+            print("Test failed, well typed program wasn't fully reduced\n");
+        }
+        interpreter_result.deallocate();
+        statements_result.deallocate();
+    }
+
+    test_optimization_pass(
+        OptimizationPassInlining,
+        "id = \\ x . x;\n"
+        "loop = \\ x . loop x;\n"
+        "main = id (loop a);\n",
+        "id = \\ x . x;\n"
+        "loop = \\ x . loop x;\n"
+        "main = (\\ x . x) (loop a);\n"
+    );
+    // both applications of pair to known arguments are the same configuration, so they share one specialization
+    test_optimization_pass(
+        OptimizationPassSpecialization,
+        "pair = \\ first second f . f first second;\n"
+        "main = \\ n . n (pair one two) (pair one two) (pair n two);\n",
+        "pair = \\ first second f . f first second;\n"
+        "main = \\ n . n pair'1 pair'1 (pair n two);\n"
+        "pair'1 = \\ f . f one two;\n"
+    );
+    test_optimization_pass(
+        OptimizationPassSpecialization,
+        "pair = \\ first second f . f first second;\n"
+        "unused = pair one two;\n"
+        "main = \\ n . n (pair n two);\n",
+        "pair = \\ first second f . f first second;\n"
+        "unused = pair one two;\n"
+        "main = \\ n . n (pair n two);\n"
+    );
+    // reducing `tree leaf` copies the unreduced argument of each `double` and reduces both of the copies, which takes
+    // longer than the whole pass is allowed to, so neither it nor anything after it gets specialized
+    test_optimization_pass(
+        OptimizationPassSpecialization,
+        "double = \\ t f . f t t;\n"
+        "tree = \\ t . double (double (double (double (double (double (double (double (double "
+        "(double (double (double (double (double (double (double (double t))))))))))))))));\n"
+        "pair = \\ first second f . f first second;\n"
+        "main = \\ n . n (tree leaf) (pair one two);\n",
+        "double = \\ t f . f t t;\n"
+        "tree = \\ t . double (double (double (double (double (double (double (double (double "
+        "(double (double (double (double (double (double (double (double t))))))))))))))));\n"
+        "pair = \\ first second f . f first second;\n"
+        "main = \\ n . n (tree leaf) (pair one two);\n"
+    );
+    test_optimization_pass(
+        OptimizationPassPreReduction,
+        "two = (\\ n f x . f (n f x)) (\\ f x . f x);\n"
+        "main = (\\ x . x) a;\n",
+        "two = \\ f x . f (f x);\n"
+        "main = (\\ x . x) a;\n"
+    );
+    test_optimization_pass(
+        OptimizationPassEtaContraction,
+        "main = \\ x . g (\\ y . x y);\n",
+        "main = g;\n"
+    );
+    test_optimization_pass(
+        OptimizationPassUnusedParameterElimination,
+        "const = \\ x y . x;\n"
+        "main = const a b;\n",
+        "const = \\ x . x;\n"
+        "main = const a;\n"
+    );
+    // const isn't applied to both of its arguments everywhere, so its parameters can't change
+    test_optimization_pass(
+        OptimizationPassUnusedParameterElimination,
+        "const = \\ x y . x;\n"
+        "main = const a;\n",
+        "const = \\ x y . x;\n"
+        "main = const a;\n"
+    );
+    test_optimizations_preserve_result(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n . \\ f x . f (n f x);\n"
+        "one = succ zero;\n"
+        "two = succ one;\n"
+        "add = \\ left right . left succ right;\n"
+        "const = \\ x y . x;\n"
+        "main = const (add one two) (add two two);\n"
+    );
+    test_optimizations_preserve_result(
+        "true = \\ iftrue iffalse . iftrue;\n"
+        "false = \\ iftrue iffalse . iffalse;\n"
+        "not = \\ boolean . boolean false true;\n"
+        "loop = \\ condition . condition (\\ x . x) (loop (not condition));\n"
+        "main = loop false;\n"
+    );
+
+    test_folding(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "two = succ (succ zero);\n"
+        "three = succ two;\n"
+        "add = \\ left right . left succ right;\n"
+        "main = add (succ zero) two;\n",
+        "three"
+    );
+    test_folding(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "two = succ (succ zero);\n"
+        "three = succ two;\n"
+        "main = \\ g . g three (succ two) (succ three);\n",
+        "\\ g . g three three (\\ f x . f (f (f (f x))))"
+    );
+
+    test_strictness(
+        "id = \\ x . x;\n"
+        "const = \\ x y . x;\n"
+        "apply = \\ f x . f x;\n"
+        "twice = \\ x . const x x;\n"
+        "loop = \\ x . loop x;\n"
+        "opaque = \\ x . constructor x;\n"
+        "grow = \\ x . grow (x x);\n"
+        "strict_apply = \\ f x . const x (f x);\n"
+        "redex = \\ x . (\\ a . x) x;\n"
+        "redex_head = \\ x . (\\ a . x) x (\\ u v . v) loop;\n",
+        "id : S\n"
+        "const : S L\n"
+        "apply : L L\n"
+        "twice : S\n"
+        "loop : L\n"
+        "opaque : S\n"
+        "grow : L\n"
+        "strict_apply : L S\n"
+        "redex : S\n"
+        "redex_head : L\n"
+    );
+    // the redex in f reduces to its parameter, which is applied to the rest of the arguments, so the parameter
+    // doesn't need to have a normal form
+    test_interpreter(
+        "f = \\ x . (\\ a . x) x (\\ u v . v) ((\\ y . y y) (\\ y . y y));\n"
+        "main = f (\\ z w . z ((\\ y . y y) (\\ y . y y)));\n",
+        "\\ v . v"
+    );
+    // `\ z . z loop` has no normal form, but applying it is fine as long as it ends up applied to a function that
+    // throws its argument away, so it mustn't be reduced ahead of time
+    test_interpreter(
+        "loop = \\ x . loop x;\n"
+        "twice = \\ f x . f (f x);\n"
+        "main = twice (\\ z . z loop) (\\ q r . d);\n",
+        "d"
+    );
+    test_interpreter(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "add = \\ left right . left succ right;\n"
+        "double = \\ n . add n n;\n"
+        "main = double (double (succ (succ zero)));\n",
+        "\\ f x . f (f (f (f (f (f (f (f x)))))))"
+    );
+
+    test_profile(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n . \\ f x . f (n f x);\n"
+        "true = \\ t f . t;\n"
+        "false = \\ t f . f;\n"
+        "iszero = \\ n . n (\\ x . false) true;\n"
+        "pred = \\ n f x . n (\\ g h . h (g f)) (\\ u . x) (\\ u . u);\n"
+        "add = \\ left right . left succ right;\n"
+        "ten = succ (succ (succ (succ (succ (succ (succ (succ (succ (succ zero)))))))));\n"
+        "sum = \\ n . iszero n zero (add n (sum (pred n)));\n"
+        "main = sum ten;\n",
+        "pred"
+    );
+    // big is too large to be inlined until the profile says it's unfolded for every one of the 64 applications
+    test_profile_guided_optimization(
+        "zero = \\ f x . x;\n"
+        "succ = \\ n f x . f (n f x);\n"
+        "mul = \\ m n f . m (n f);\n"
+        "eight = succ (succ (succ (succ (succ (succ (succ (succ zero)))))));\n"
+        "sixtyfour = mul eight eight;\n"
+        "big = \\ m f x . f (f (f (f (f (f (m f x))))));\n"
+        "main = \\ g . sixtyfour big g;\n",
+        "big"
+    );
+    auto invalid_profile_source = String::copy_from_c_string("pred 12\n");
+    if (Profile::parse(invalid_profile_source).has_data)
+    {
+        print("Test failed, a profile line without the allocated nodes was accepted\n");
+    }
+    invalid_profile_source.deallocate();
+
+    test_tokenizer("main = \\ x . x;");
+    test_tokenizer(
+        "a_very_long_name_that_spans_more_than_one_block  =   \\ x0 x1 . x0;\n\n\t\r\n                  main"
+    );
+    test_tokenizer("                                ends_with_a_name_longer_than_sixteen_characters");
+    test_tokenizer("main = \\ x . x  # comments aren't a thing                                 ");
+    test_tokenizer("main = \\ x . x_\xc3\xa9_not_ascii_is_not_a_name_either");
+    test_tokenizer("ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz_0123456789 @ `{[");
+
     print("Done\n");
 }
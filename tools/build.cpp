@@ -3,6 +3,7 @@
 enum Mode
 {
     ModeRunTests,
+    ModeRunBenchmarks,
     ModeBuildExecutable,
 };
 
@@ -40,6 +41,10 @@ Result<CliArguments, String> parse_cli_arguments(CStringView cli_arguments_strin
     {
         mode = ModeRunTests;
     }
+    else if (c_string_starts_with_case_insensitive("benchmarks", cli_arguments_string + index))
+    {
+        mode = ModeRunBenchmarks;
+    }
     else if (c_string_starts_with_case_insensitive("build", cli_arguments_string + index))
     {
         mode = ModeBuildExecutable;
@@ -90,6 +95,7 @@ int run_tests()
     command.push(" /ENTRY:main");
     command.push(" /SUBSYSTEM:console");
     command.push(" kernel32.lib");
+    command.push(" advapi32.lib"); // for enabling large pages
 
     command.make_c_string_compatible();
 
@@ -104,6 +110,54 @@ int run_tests()
     return (int)complete(start_cmd(tests_command));
 }
 
+int run_benchmarks()
+{
+    // have to do this because otherwise cl will not be able to compile
+    if (!directory_exists("temp"))
+    {
+        auto success = CreateDirectoryA("temp", nullptr);
+        if (!success)
+        {
+            print("Failed to create temp directory\n");
+            return 1;
+        }
+    }
+
+    auto command = String::allocate();
+    command.push("cl"); // MSVC compiler
+
+    // compiler options:
+    command.push(" /nologo");
+    command.push(" /O2"); // benchmarks are meaningless without optimizations
+    command.push(" /Fo.\\temp\\"); // directory for temporary build files
+    command.push(" /Fe.\\temp\\lci_benchmarks.exe"); // output path
+    command.push(" /Gy"); // collapse identical functions, https://stackoverflow.com/a/629978
+    command.push(" /GS-"); // disable buffer security checks
+    command.push(" /Zl"); // ignore CRT when compiling object files
+    command.push(" /I."); // use current directory for includes
+    command.push(" test\\benchmark.cpp");
+
+    // linker options:
+    command.push(" /link");
+    command.push(" /NODEFAULTLIB"); // ignore CRT when linking
+    command.push(" /ENTRY:main");
+    command.push(" /SUBSYSTEM:console");
+    command.push(" kernel32.lib");
+    command.push(" advapi32.lib"); // for enabling large pages
+
+    command.make_c_string_compatible();
+
+    print(command, "\n");
+    auto exit_code = (int)complete(start_cmd(command.data));
+    command.deallocate();
+    if (exit_code != 0) { return exit_code; }
+
+    print("Running benchmarks...\n");
+    auto benchmarks_command = "temp\\lci_benchmarks";
+    print(benchmarks_command, "\n");
+    return (int)complete(start_cmd(benchmarks_command));
+}
+
 int build_executable()
 {
     // have to do this because otherwise cl will not be able to compile
@@ -136,6 +190,7 @@ int build_executable()
     command.push(" /ENTRY:main");
     command.push(" /SUBSYSTEM:console");
     command.push(" kernel32.lib");
+    command.push(" advapi32.lib"); // for enabling large pages
 
     command.make_c_string_compatible();
 
@@ -167,6 +222,7 @@ int main()
     switch (cli_arguments.mode)
     {
         case ModeRunTests: return run_tests();
+        case ModeRunBenchmarks: return run_benchmarks();
         // I don't know why, but just returning from main after calling build_executable doesn't actually exit the
         // program, it just stays there hanging, so we have to force it to quit with ExitProcess
         case ModeBuildExecutable: ExitProcess(build_executable());